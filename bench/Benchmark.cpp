@@ -0,0 +1,446 @@
+/**
+ * Benchmark suite for the building blocks of the minimum mean cycle computation: DIMACS parsing, a single Dijkstra run
+ * (with the default radix heap and, as "dijkstra_binary_heap", with a binary heap), a full minimum T-join (and the
+ * matching part of it), the end-to-end find_mmc and a re-solve after changing 0.1% of the weights, on complete graphs, sparse random graphs, grids and planar
+ * triangulations. Further instances, e.g. those created by generate_instances.sh, can be added
+ * with --instance. Results are printed and can be written as JSON to compare versions.
+ *
+ * Usage: mmc_bench [--size small|medium|large] [--repetitions N] [--threads N] [--t-join all-pairs|voronoi]
+ *                  [--storage sparse|dense|compact] [--kernels scalar|avx2|avx512] [--filter TEXT] [--instance PATH]...
+ *                  [--label TEXT] [--json PATH]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+#include "DenseKernels.h"
+#include "Gamma.h"
+#include "InstanceGenerator.h"
+#include "MinimumMeanCycleCalculator.h"
+#include "ShortestPathCalculator.h"
+#include "Solver.h"
+#include "TJoinCalculator.h"
+
+namespace {
+
+using namespace MMC;
+
+enum class InstanceSize {
+    small,
+    medium,
+    large,
+};
+
+struct Arguments {
+    InstanceSize size = InstanceSize::small;
+    unsigned repetitions = 3;
+    unsigned num_threads = 1;
+    /// If not set, all-pairs is used on complete graphs and voronoi on all other graphs
+    std::optional<TJoinStrategy> t_join_strategy;
+    /// Used for the complete graphs and the instance files
+    GraphStorage storage = GraphStorage::sparse;
+    /// If not set, the best instruction set supported by the CPU is used
+    std::optional<KernelIsa> kernels;
+    std::string filter;
+    /// Graph files benchmarked in addition to the generated instances
+    std::vector<std::string> instance_paths;
+    std::string label;
+    std::string json_path;
+};
+
+struct Instance {
+    std::string family;
+    /// Human readable description of the generator parameters
+    std::string parameters;
+    Graph graph;
+};
+
+/// All timings of one operation on one instance
+struct Measurement {
+    std::string operation;
+    Instance const* instance;
+    std::string t_join_strategy;
+    std::vector<double> seconds;
+
+    [[nodiscard]] double min() const {
+        return *std::min_element(seconds.begin(), seconds.end());
+    }
+
+    [[nodiscard]] double median() const {
+        auto sorted = seconds;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[sorted.size() / 2];
+    }
+
+    [[nodiscard]] double mean() const {
+        return std::accumulate(seconds.begin(), seconds.end(), 0.) / static_cast<double>(seconds.size());
+    }
+};
+
+void print_usage(char const* program_name) {
+    std::cout << "Usage: " << program_name << " [options]\n"
+              << "Options:\n"
+              << "  --size <small|medium|large>  Size of the generated instances (default small)\n"
+              << "  --repetitions <N>            Number of timed runs per benchmark (default 3)\n"
+              << "  --threads <N>                Number of threads for the shortest path computations (default 1)\n"
+              << "  --t-join <all-pairs|voronoi> T-join algorithm for all families (default all-pairs on complete\n"
+              << "                               graphs, voronoi otherwise)\n"
+              << "  --storage <sparse|dense|compact>\n"
+              << "                               Storage of the complete graphs and --instance files (default sparse)\n"
+              << "  --kernels <scalar|avx2|avx512>\n"
+              << "                               Instruction set of the dense kernels (default: best supported)\n"
+              << "  --filter <text>              Only run benchmarks whose name contains text\n"
+              << "  --instance <path>            Also benchmark this graph file (DIMACS or binary), can be repeated\n"
+              << "  --label <text>               Stored in the JSON output, e.g. the version being measured\n"
+              << "  --json <path>                Write the results as JSON to this file\n";
+}
+
+std::optional<Arguments> parse_arguments(int argc, char** argv) {
+    Arguments result;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string const argument{argv[i]};
+            if (i + 1 >= argc) {
+                std::cout << "Missing value for " << argument << std::endl;
+                return std::nullopt;
+            }
+            std::string const value{argv[++i]};
+            if (argument == "--size") {
+                if (value == "small") {
+                    result.size = InstanceSize::small;
+                } else if (value == "medium") {
+                    result.size = InstanceSize::medium;
+                } else if (value == "large") {
+                    result.size = InstanceSize::large;
+                } else {
+                    std::cout << "Unknown size " << value << std::endl;
+                    return std::nullopt;
+                }
+            } else if (argument == "--repetitions") {
+                result.repetitions = std::max(1u, static_cast<unsigned>(std::stoul(value)));
+            } else if (argument == "--threads") {
+                result.num_threads = static_cast<unsigned>(std::stoul(value));
+            } else if (argument == "--t-join") {
+                if (value == "all-pairs") {
+                    result.t_join_strategy = TJoinStrategy::all_pairs;
+                } else if (value == "voronoi") {
+                    result.t_join_strategy = TJoinStrategy::voronoi_pricing;
+                } else {
+                    std::cout << "Unknown T-join strategy " << value << std::endl;
+                    return std::nullopt;
+                }
+            } else if (argument == "--storage") {
+                if (value == "sparse") {
+                    result.storage = GraphStorage::sparse;
+                } else if (value == "dense") {
+                    result.storage = GraphStorage::dense;
+                } else if (value == "compact") {
+                    result.storage = GraphStorage::compact_dense;
+                } else {
+                    std::cout << "Unknown storage " << value << std::endl;
+                    return std::nullopt;
+                }
+            } else if (argument == "--kernels") {
+                if (value == "scalar") {
+                    result.kernels = KernelIsa::scalar;
+                } else if (value == "avx2") {
+                    result.kernels = KernelIsa::avx2;
+                } else if (value == "avx512") {
+                    result.kernels = KernelIsa::avx512;
+                } else {
+                    std::cout << "Unknown instruction set " << value << std::endl;
+                    return std::nullopt;
+                }
+            } else if (argument == "--filter") {
+                result.filter = value;
+            } else if (argument == "--instance") {
+                result.instance_paths.push_back(value);
+            } else if (argument == "--label") {
+                result.label = value;
+            } else if (argument == "--json") {
+                result.json_path = value;
+            } else {
+                std::cout << "Unknown option " << argument << std::endl;
+                return std::nullopt;
+            }
+        }
+    } catch (std::exception const&) {
+        std::cout << "Invalid number" << std::endl;
+        return std::nullopt;
+    }
+    return result;
+}
+
+char const* storage_name(GraphStorage const storage) {
+    switch (storage) {
+        case GraphStorage::dense:
+            return "dense";
+        case GraphStorage::compact_dense:
+            return "compact";
+        default:
+            return "sparse";
+    }
+}
+
+/// The same graph with different storage
+Graph with_storage(Graph const& graph, GraphStorage const storage) {
+    if (graph.storage() == storage) {
+        return graph;
+    }
+    std::vector<Edge> edges(graph.num_edges());
+    for (EdgeIndex i = 0; i < graph.num_edges(); ++i) {
+        edges[i] = graph.edge(i);
+    }
+    return Graph(graph.num_nodes(), std::move(edges), graph.edge_weights(), storage);
+}
+
+std::vector<Instance> make_instances(
+        InstanceSize const size, std::vector<std::string> const& instance_paths, GraphStorage const storage
+) {
+    // Every size step multiplies the number of nodes by roughly ten
+    NodeId const scale = size == InstanceSize::small ? 1 : size == InstanceSize::medium ? 10 : 100;
+    NodeId const complete_nodes = size == InstanceSize::small ? 100 : size == InstanceSize::medium ? 300 : 1000;
+    NodeId const side = size == InstanceSize::small ? 40 : size == InstanceSize::medium ? 125 : 400;
+    InstanceGenerator generator(42, 1000);
+    std::vector<Instance> instances;
+    // Dense storage is only used where it is sensible, a matrix for the other families would not fit into memory
+    instances.push_back({
+            "complete", "n=" + std::to_string(complete_nodes), with_storage(generator.complete(complete_nodes), storage)
+    });
+    instances.push_back({
+            "sparse", "n=" + std::to_string(2000 * scale) + ",m=" + std::to_string(6000 * scale),
+            generator.random_sparse(2000 * scale, 6000 * scale)
+    });
+    auto const grid_parameters = std::to_string(side) + "x" + std::to_string(side);
+    instances.push_back({"grid", grid_parameters, generator.grid(side, side)});
+    instances.push_back({"planar", grid_parameters, generator.planar(side, side)});
+    for (auto const& path : instance_paths) {
+        instances.push_back({
+                "file", std::filesystem::path(path).filename().string(), Graph::read_file(path, storage)
+        });
+    }
+    return instances;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point const start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// The mean edge weight, a gamma for which about half of the edges are negative
+Gamma mean_weight(Graph const& graph) {
+    AccumulatedEdgeWeight sum = 0;
+    for (EdgeIndex i = 0; i < graph.num_edges(); ++i) {
+        sum += graph.edge_weight(i);
+    }
+    return Gamma{sum, std::max<size_t>(1, graph.num_edges())};
+}
+
+std::string json_escaped(std::string const& text) {
+    std::string result;
+    for (auto const character : text) {
+        if (character == '"' or character == '\\') {
+            result += '\\';
+        }
+        result += character;
+    }
+    return result;
+}
+
+void write_json(std::ostream& output, Arguments const& arguments, std::vector<Measurement> const& measurements) {
+    auto const now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    output << "{\n"
+           << "  \"context\": {\n"
+           << "    \"label\": \"" << json_escaped(arguments.label) << "\",\n"
+           << "    \"date\": \"" << date << "\",\n"
+           << "    \"compiler\": \"" << json_escaped(__VERSION__) << "\",\n"
+#ifdef NDEBUG
+           << "    \"assertions\": false,\n"
+#else
+           << "    \"assertions\": true,\n"
+#endif
+           << "    \"repetitions\": " << arguments.repetitions << ",\n"
+           << "    \"threads\": " << arguments.num_threads << ",\n"
+           << "    \"storage\": \"" << storage_name(arguments.storage) << "\",\n"
+           << "    \"kernels\": \"" << to_string(kernel_isa()) << "\"\n"
+           << "  },\n"
+           << "  \"benchmarks\": [";
+    for (size_t i = 0; i < measurements.size(); ++i) {
+        auto const& measurement = measurements[i];
+        auto const& instance = *measurement.instance;
+        output << (i == 0 ? "\n" : ",\n")
+               << "    {\"name\": \"" << measurement.operation << '/' << instance.family << '/'
+               << json_escaped(instance.parameters) << "\", "
+               << "\"operation\": \"" << measurement.operation << "\", "
+               << "\"family\": \"" << instance.family << "\", "
+               << "\"parameters\": \"" << json_escaped(instance.parameters) << "\", "
+               << "\"nodes\": " << instance.graph.num_nodes() << ", "
+               << "\"edges\": " << instance.graph.num_edges() << ", "
+               << "\"t_join\": \"" << measurement.t_join_strategy << "\", "
+               << "\"min_seconds\": " << measurement.min() << ", "
+               << "\"median_seconds\": " << measurement.median() << ", "
+               << "\"mean_seconds\": " << measurement.mean() << ", "
+               << "\"seconds\": [";
+        for (size_t j = 0; j < measurement.seconds.size(); ++j) {
+            output << (j == 0 ? "" : ", ") << measurement.seconds[j];
+        }
+        output << "]}";
+    }
+    output << "\n  ]\n}\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    auto const arguments = parse_arguments(argc, argv);
+    if (not arguments) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    try {
+        if (arguments->kernels) {
+            set_kernel_isa(*arguments->kernels);
+        }
+        std::cout << "Generating instances (kernels: " << to_string(kernel_isa()) << ")..." << std::endl;
+        auto const instances = make_instances(arguments->size, arguments->instance_paths, arguments->storage);
+        auto const dimacs_path = std::filesystem::temp_directory_path() / "mmc_bench.dimacs";
+
+        std::vector<Measurement> measurements;
+        auto const record = [&](Measurement measurement) {
+            std::cout << measurement.operation << '/' << measurement.instance->family << " ("
+                      << measurement.instance->parameters << "): min " << measurement.min() << "s, median "
+                      << measurement.median() << "s" << std::endl;
+            measurements.push_back(std::move(measurement));
+        };
+        auto const selected = [&](std::string const& operation, Instance const& instance) {
+            return (operation + '/' + instance.family).find(arguments->filter) != std::string::npos;
+        };
+
+        for (auto const& instance : instances) {
+            auto const& graph = instance.graph;
+            TJoinOptions t_join_options{};
+            t_join_options.num_threads = arguments->num_threads;
+            auto const is_complete = 2 * static_cast<size_t>(graph.num_edges())
+                                     == static_cast<size_t>(graph.num_nodes()) * (graph.num_nodes() - 1);
+            t_join_options.strategy = arguments->t_join_strategy.value_or(
+                    is_complete ? TJoinStrategy::all_pairs : TJoinStrategy::voronoi_pricing
+            );
+            std::string const strategy_name =
+                    t_join_options.strategy == TJoinStrategy::all_pairs ? "all-pairs" : "voronoi";
+            auto const gamma = mean_weight(graph);
+
+            if (selected("parse", instance)) {
+                {
+                    std::ofstream output(dimacs_path);
+                    graph.write_dimacs(output);
+                }
+                Measurement measurement{"parse", &instance, "", {}};
+                for (unsigned i = 0; i < arguments->repetitions; ++i) {
+                    auto const start = std::chrono::steady_clock::now();
+                    auto const parsed = Graph::read_dimacs_file(dimacs_path.string());
+                    measurement.seconds.push_back(seconds_since(start));
+                }
+                std::filesystem::remove(dimacs_path);
+                record(std::move(measurement));
+            }
+            if (selected("dijkstra", instance)) {
+                Measurement measurement{"dijkstra", &instance, "", {}};
+                for (unsigned i = 0; i < arguments->repetitions; ++i) {
+                    auto const start = std::chrono::steady_clock::now();
+                    ShortestPathCalculator calculator(0, graph, gamma);
+                    calculator.run_to_completion();
+                    measurement.seconds.push_back(seconds_since(start));
+                }
+                record(std::move(measurement));
+            }
+            if (selected("dijkstra_binary_heap", instance)) {
+                Measurement measurement{"dijkstra_binary_heap", &instance, "", {}};
+                for (unsigned i = 0; i < arguments->repetitions; ++i) {
+                    auto const start = std::chrono::steady_clock::now();
+                    BasicShortestPathCalculator<BinaryHeap> calculator(0, graph, gamma);
+                    calculator.run_to_completion();
+                    measurement.seconds.push_back(seconds_since(start));
+                }
+                record(std::move(measurement));
+            }
+            if (selected("t_join", instance) or selected("matching", instance)) {
+                Measurement t_join{"t_join", &instance, strategy_name, {}};
+                Measurement matching{"matching", &instance, strategy_name, {}};
+                for (unsigned i = 0; i < arguments->repetitions; ++i) {
+                    auto const start = std::chrono::steady_clock::now();
+                    TJoinCalculator calculator(graph, t_join_options);
+                    auto const join = calculator.get_minimum_zero_join(gamma);
+                    t_join.seconds.push_back(seconds_since(start));
+                    auto const& statistics = calculator.matching_statistics();
+                    matching.seconds.push_back(statistics.cold_solve_seconds + statistics.warm_solve_seconds);
+                }
+                if (selected("t_join", instance)) {
+                    record(std::move(t_join));
+                }
+                if (selected("matching", instance)) {
+                    record(std::move(matching));
+                }
+            }
+            if (selected("find_mmc", instance)) {
+                Measurement measurement{"find_mmc", &instance, strategy_name, {}};
+                MinimumMeanCycleOptions options{};
+                options.t_join = t_join_options;
+                for (unsigned i = 0; i < arguments->repetitions; ++i) {
+                    auto const start = std::chrono::steady_clock::now();
+                    MinimumMeanCycleCalculator calculator(graph, options);
+                    auto const result = calculator.find_mmc();
+                    measurement.seconds.push_back(seconds_since(start));
+                }
+                record(std::move(measurement));
+            }
+            if (selected("resolve", instance) and graph.num_edges() > 0) {
+                // Only the re-solve is timed, seeded with the solution before the weight changes
+                Measurement measurement{"resolve", &instance, strategy_name, {}};
+                MinimumMeanCycleOptions options{};
+                options.t_join = t_join_options;
+                Solver solver(options);
+                solver.set_graph(graph);
+                solver.solve();
+                std::mt19937 random(7);
+                std::uniform_int_distribution<EdgeIndex> random_edge(0, graph.num_edges() - 1);
+                std::uniform_int_distribution<EdgeWeight> random_weight(-1000, 1000);
+                for (unsigned i = 0; i < arguments->repetitions; ++i) {
+                    std::vector<EdgeWeightUpdate> updates(std::max<EdgeIndex>(1, graph.num_edges() / 1000));
+                    for (auto& update : updates) {
+                        update = EdgeWeightUpdate{graph.edge(random_edge(random)), random_weight(random)};
+                    }
+                    solver.update_edge_weights(updates);
+                    auto const start = std::chrono::steady_clock::now();
+                    auto const result = solver.solve();
+                    measurement.seconds.push_back(seconds_since(start));
+                }
+                record(std::move(measurement));
+            }
+        }
+
+        if (not arguments->json_path.empty()) {
+            std::ofstream output(arguments->json_path);
+            if (not output) {
+                throw std::runtime_error("Failed to open " + arguments->json_path);
+            }
+            write_json(output, *arguments, measurements);
+        }
+        return EXIT_SUCCESS;
+    } catch (std::exception const& xcp) {
+        std::cerr << "Caught exception: " << xcp.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,83 @@
+/**
+ * Compares the stream-based DIMACS reader with the memory-mapped one and with loading the binary format.
+ *
+ * Usage: mmc_load_bench <graph file> [threads] [repetitions]
+ * The binary version of the graph is written next to the input file (with suffix .mmcg) and removed afterwards.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "graph.h"
+#include "Parallel.h"
+
+namespace {
+
+template<class Load>
+double best_seconds(unsigned const repetitions, Load const& load) {
+    double best = 0;
+    for (unsigned i = 0; i < repetitions; ++i) {
+        auto const start = std::chrono::steady_clock::now();
+        auto const graph = load();
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0 or elapsed.count() < best) {
+            best = elapsed.count();
+        }
+        if (graph.num_nodes() == 0 and graph.num_edges() == 0) {
+            std::cout << "(empty graph)\n";
+        }
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char** argv) {
+    using namespace MMC;
+    if (argc < 2 or argc > 4) {
+        std::cout << "Usage: " << argv[0] << " <graph file> [threads] [repetitions]\n";
+        return EXIT_FAILURE;
+    }
+    std::string const path = argv[1];
+    try {
+        auto const num_threads = resolve_num_threads(argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 0);
+        auto const repetitions = argc > 3 ? static_cast<unsigned>(std::stoul(argv[3])) : 3u;
+
+        auto const stream_seconds = best_seconds(repetitions, [&]() {
+            std::ifstream input{path};
+            return Graph::read_dimacs(input);
+        });
+        auto const mapped_seconds = best_seconds(repetitions, [&]() {
+            return Graph::read_dimacs_file(path, GraphStorage::sparse, 1);
+        });
+        auto const parallel_seconds = best_seconds(repetitions, [&]() {
+            return Graph::read_dimacs_file(path, GraphStorage::sparse, num_threads);
+        });
+        auto const binary_path = path + ".mmcg";
+        Graph::read_dimacs_file(path, GraphStorage::sparse, num_threads).write_binary_file(binary_path);
+        auto const binary_seconds = best_seconds(repetitions, [&]() {
+            return Graph::read_binary_file(binary_path);
+        });
+        auto const unchecked_binary_seconds = best_seconds(repetitions, [&]() {
+            return Graph::read_binary_file(binary_path, GraphStorage::sparse, false);
+        });
+        std::remove(binary_path.c_str());
+
+        std::cout << "stream reader:               " << stream_seconds << "s\n"
+                  << "mapped reader, 1 thread:     " << mapped_seconds << "s (" << stream_seconds / mapped_seconds
+                  << "x)\n"
+                  << "mapped reader, " << num_threads << " thread(s):  " << parallel_seconds << "s ("
+                  << stream_seconds / parallel_seconds << "x)\n"
+                  << "binary format:               " << binary_seconds << "s (" << stream_seconds / binary_seconds
+                  << "x)\n"
+                  << "binary format, no checksum:  " << unchecked_binary_seconds << "s ("
+                  << stream_seconds / unchecked_binary_seconds << "x)\n";
+        return EXIT_SUCCESS;
+    } catch (std::exception const& xcp) {
+        std::cerr << "Caught exception: " << xcp.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,176 @@
+/**
+ * Checks and times WidePerfectMatching, the 64 bit matching used when costs exceed the range of Blossom V.
+ *
+ * Two reproducible comparisons are run for every seed:
+ *  - matching: a complete graph with random costs in the range of Blossom V is solved by both matchers, and the
+ *    solution scaled to costs close to WidePerfectMatching::max_cost by the wide one. All three have to agree.
+ *  - find_mmc: a random graph is solved, and then again with all weights multiplied by a factor that forces the T-join
+ *    computations onto the wide matching. The mean of the second cycle has to be the factor times the first.
+ *
+ * Usage: mmc_matching_bench [num_nodes] [seeds] [t-join strategy all-pairs|voronoi]
+ * Exits with EXIT_FAILURE if any comparison fails.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+#include "InstanceGenerator.h"
+#include "MinimumMeanCycleCalculator.h"
+#include "WidePerfectMatching.h"
+#include "blossomv/PerfectMatching.h"
+
+namespace {
+
+using namespace MMC;
+
+/// Matching costs drawn for the comparison, well inside the range passed to Blossom V
+constexpr WidePerfectMatching::Cost max_narrow_cost = 1000000;
+/// Weights of the graphs solved by find_mmc, multiplied by weight_scale for the wide run
+constexpr EdgeWeight max_narrow_weight = 1000;
+constexpr EdgeWeight weight_scale = std::numeric_limits<EdgeWeight>::max() / max_narrow_weight;
+
+double seconds_since(std::chrono::steady_clock::time_point const start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct CostedEdge {
+    size_t first;
+    size_t second;
+    WidePerfectMatching::Cost cost;
+};
+
+/// The cost of the perfect matching given by match, or -1 if match is not a perfect matching of the edges
+WidePerfectMatching::Cost matching_cost(
+        std::vector<CostedEdge> const& edges, size_t const num_nodes, std::vector<size_t> const& match
+) {
+    WidePerfectMatching::Cost cost = 0;
+    size_t num_matched = 0;
+    for (auto const& edge : edges) {
+        if (match[edge.first] == edge.second and match[edge.second] == edge.first) {
+            cost += edge.cost;
+            num_matched += 2;
+        }
+    }
+    return num_matched == num_nodes ? cost : -1;
+}
+
+bool compare_matchings(size_t const num_nodes, uint64_t const seed) {
+    std::mt19937_64 random(seed);
+    std::uniform_int_distribution<WidePerfectMatching::Cost> random_cost(0, max_narrow_cost);
+    std::vector<CostedEdge> edges;
+    for (size_t first = 0; first < num_nodes; ++first) {
+        for (size_t second = first + 1; second < num_nodes; ++second) {
+            edges.push_back(CostedEdge{first, second, random_cost(random)});
+        }
+    }
+    std::vector<size_t> match(num_nodes);
+
+    auto start = std::chrono::steady_clock::now();
+    PerfectMatching blossom_v(static_cast<int>(num_nodes), static_cast<int>(edges.size()));
+    blossom_v.options.verbose = false;
+    for (auto const& edge : edges) {
+        blossom_v.AddEdge(static_cast<int>(edge.first), static_cast<int>(edge.second),
+                          static_cast<PerfectMatching::REAL>(edge.cost));
+    }
+    blossom_v.Solve();
+    auto const blossom_v_seconds = seconds_since(start);
+    for (size_t node = 0; node < num_nodes; ++node) {
+        match[node] = static_cast<size_t>(blossom_v.GetMatch(static_cast<int>(node)));
+    }
+    auto const blossom_v_cost = matching_cost(edges, num_nodes, match);
+
+    auto const solve_wide = [&]() {
+        auto const wide_start = std::chrono::steady_clock::now();
+        WidePerfectMatching wide(num_nodes);
+        for (auto const& edge : edges) {
+            wide.add_edge(edge.first, edge.second, edge.cost);
+        }
+        wide.solve();
+        auto const seconds = seconds_since(wide_start);
+        for (size_t node = 0; node < num_nodes; ++node) {
+            match[node] = wide.match(node);
+        }
+        return std::make_pair(matching_cost(edges, num_nodes, match), seconds);
+    };
+    auto const[wide_cost, wide_seconds] = solve_wide();
+
+    // Scaling all costs keeps the optimal matchings. The scaled costs are far outside the range of Blossom V.
+    auto const scale = WidePerfectMatching::max_cost / max_narrow_cost;
+    for (auto& edge : edges) {
+        edge.cost *= scale;
+    }
+    auto const[scaled_cost, scaled_seconds] = solve_wide();
+
+    bool const agree = blossom_v_cost >= 0 and wide_cost == blossom_v_cost and scaled_cost == scale * blossom_v_cost;
+    std::cout << "matching  n=" << num_nodes << " seed=" << seed << ": Blossom V " << blossom_v_cost << " in "
+              << blossom_v_seconds << "s, wide " << wide_cost << " in " << wide_seconds << "s, scaled wide "
+              << scaled_cost << " (" << scale << " x) in " << scaled_seconds << "s" << (agree ? "" : "  MISMATCH")
+              << '\n';
+    return agree;
+}
+
+bool compare_find_mmc(NodeId const num_nodes, uint64_t const seed, TJoinStrategy const strategy) {
+    InstanceGenerator generator(seed, max_narrow_weight);
+    auto const graph = generator.random_sparse(num_nodes, 4 * EdgeIndex{num_nodes});
+    std::vector<Edge> edges;
+    std::vector<EdgeWeight> scaled_weights;
+    for (EdgeIndex i = 0; i < graph.num_edges(); ++i) {
+        edges.push_back(graph.edge(i));
+        scaled_weights.push_back(graph.edge_weights()[i] * weight_scale);
+    }
+    Graph const scaled_graph(num_nodes, edges, scaled_weights);
+
+    MinimumMeanCycleOptions options{};
+    options.t_join.strategy = strategy;
+    auto start = std::chrono::steady_clock::now();
+    auto const cycle = MinimumMeanCycleCalculator(graph, options).find_mmc();
+    auto const narrow_seconds = seconds_since(start);
+    start = std::chrono::steady_clock::now();
+    auto const scaled_cycle = MinimumMeanCycleCalculator(scaled_graph, options).find_mmc();
+    auto const scaled_seconds = seconds_since(start);
+
+    bool const agree = cycle.has_value() == scaled_cycle.has_value()
+                       and (not cycle or scaled_cycle->second == Gamma{cycle->second.cost_sum * weight_scale,
+                                                                         cycle->second.num_edges});
+    std::cout << "find_mmc  n=" << num_nodes << " seed=" << seed << ": mean "
+              << (cycle ? static_cast<double>(cycle->second) : 0.0) << " in " << narrow_seconds << "s, scaled mean "
+              << (scaled_cycle ? static_cast<double>(scaled_cycle->second) : 0.0) << " (" << weight_scale
+              << " x) in " << scaled_seconds << "s" << (agree ? "" : "  MISMATCH") << '\n';
+    return agree;
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc > 4) {
+        std::cout << "Usage: " << argv[0] << " [num_nodes] [seeds] [t-join strategy all-pairs|voronoi]\n";
+        return EXIT_FAILURE;
+    }
+    try {
+        auto const num_nodes = argc > 1 ? static_cast<NodeId>(std::stoul(argv[1])) : NodeId{200};
+        auto const num_seeds = argc > 2 ? std::stoul(argv[2]) : 5ul;
+        std::string const strategy_name = argc > 3 ? argv[3] : "all-pairs";
+        if (strategy_name != "all-pairs" and strategy_name != "voronoi") {
+            throw std::runtime_error("Unknown t-join strategy " + strategy_name);
+        }
+        auto const strategy = strategy_name == "voronoi" ? TJoinStrategy::voronoi_pricing : TJoinStrategy::all_pairs;
+
+        bool all_agree = true;
+        for (uint64_t seed = 1; seed <= num_seeds; ++seed) {
+            // A perfect matching needs an even number of nodes
+            all_agree = compare_matchings(num_nodes - num_nodes % 2, seed) and all_agree;
+            all_agree = compare_find_mmc(num_nodes, seed, strategy) and all_agree;
+        }
+        std::cout << (all_agree ? "All results agree.\n" : "Some results differ!\n");
+        return all_agree ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (std::exception const& xcp) {
+        std::cerr << "Caught exception: " << xcp.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -15,7 +15,7 @@ if {$argc != 1 && $argc != 2} {
 # Parse input
 set num_nodes [lindex $argv 0]
 if {$argc >= 2} {
-    set maxiumm_absolute_weight [lindex $argv 1]
+    set maximum_absolute_weight [lindex $argv 1]
 }
 
 # Check input
@@ -0,0 +1,222 @@
+#include "BatchSolver.h" // always include corresponding header first
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include "Parallel.h"
+#include "Solver.h"
+
+namespace MMC {
+
+namespace {
+
+/// Limits the sum of the amounts held at the same time. An amount larger than the limit is granted if nothing is held.
+class MemoryBudget {
+public:
+    explicit MemoryBudget(size_t const limit) : _limit(limit) {}
+
+    void acquire(size_t const amount) {
+        if (_limit == 0) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        _released.wait(lock, [&] { return _used == 0 or _used + amount <= _limit; });
+        _used += amount;
+    }
+
+    void release(size_t const amount) {
+        if (_limit == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _used -= amount;
+        }
+        _released.notify_all();
+    }
+
+private:
+    size_t const _limit;
+    size_t _used = 0;
+    std::mutex _mutex;
+    std::condition_variable _released;
+};
+
+std::string default_output_path(std::filesystem::path const& input_path, std::string const& output_directory) {
+    return (std::filesystem::path(output_directory) / input_path.filename()).string() + ".out";
+}
+
+/// Throws if two jobs write to the same output path, one of the results would be lost
+void check_distinct_outputs(std::vector<BatchJob> const& jobs) {
+    std::vector<std::filesystem::path> outputs;
+    outputs.reserve(jobs.size());
+    for (auto const& job : jobs) {
+        outputs.push_back(std::filesystem::path(job.output_path).lexically_normal());
+    }
+    std::sort(outputs.begin(), outputs.end());
+    auto const duplicate = std::adjacent_find(outputs.begin(), outputs.end());
+    if (duplicate != outputs.end()) {
+        throw std::runtime_error("Several batch jobs write to " + duplicate->string()
+                                 + ", give distinct output paths in the manifest");
+    }
+}
+
+double seconds_since(std::chrono::steady_clock::time_point const start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // end of anonymous namespace
+
+std::vector<BatchJob> read_batch_manifest(std::string const& manifest_path, std::string const& output_directory) {
+    std::ifstream manifest(manifest_path);
+    if (not manifest) {
+        throw std::runtime_error("Failed to open the batch manifest " + manifest_path);
+    }
+    auto const base_directory = std::filesystem::path(manifest_path).parent_path();
+    std::vector<BatchJob> jobs;
+    std::string line;
+    for (size_t line_number = 1; std::getline(manifest, line); ++line_number) {
+        if (not line.empty() and line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(" \t") == std::string::npos or line[0] == '#') {
+            continue;
+        }
+        // Paths may contain spaces, so only a tab separates the input from the output path
+        auto const separator = line.find('\t');
+        auto const input = line.substr(0, separator);
+        auto const output = separator == std::string::npos ? std::string{} : line.substr(separator + 1);
+        if (input.empty() or output.find('\t') != std::string::npos) {
+            throw std::runtime_error("Invalid line " + std::to_string(line_number) + " in the batch manifest "
+                                     + manifest_path + ": expected an input path, optionally followed by a tab and "
+                                     + "an output path");
+        }
+        auto const input_path = base_directory / input;
+        jobs.push_back(BatchJob{
+                input_path.string(),
+                output.empty() ? default_output_path(input_path, output_directory) : (base_directory / output).string()
+        });
+    }
+    check_distinct_outputs(jobs);
+    return jobs;
+}
+
+std::vector<BatchJob> list_batch_directory(std::string const& input_directory, std::string const& output_directory) {
+    std::vector<std::filesystem::path> inputs;
+    for (auto const& entry : std::filesystem::directory_iterator(input_directory)) {
+        if (entry.is_regular_file()) {
+            inputs.push_back(entry.path());
+        }
+    }
+    std::sort(inputs.begin(), inputs.end());
+    std::vector<BatchJob> jobs;
+    jobs.reserve(inputs.size());
+    for (auto const& input : inputs) {
+        jobs.push_back(BatchJob{input.string(), default_output_path(input, output_directory)});
+    }
+    return jobs;
+}
+
+std::vector<BatchResult> solve_batch(std::vector<BatchJob> const& jobs, BatchOptions const& options) {
+    check_distinct_outputs(jobs);
+    // Start with the largest inputs, so that the last jobs to finish are short ones
+    std::vector<uintmax_t> input_sizes(jobs.size(), 0);
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        std::error_code error;
+        auto const size = std::filesystem::file_size(jobs[i].input_path, error);
+        input_sizes[i] = error ? 0 : size;
+    }
+    std::vector<size_t> order(jobs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&input_sizes](size_t const a, size_t const b) {
+        return input_sizes[a] > input_sizes[b];
+    });
+
+    auto const num_jobs = resolve_num_threads(options.num_jobs);
+    std::vector<Solver> solvers;
+    solvers.reserve(num_jobs);
+    for (unsigned i = 0; i < num_jobs; ++i) {
+        solvers.emplace_back(options.solver);
+    }
+    MemoryBudget budget(options.memory_limit_bytes);
+    std::vector<BatchResult> results(jobs.size());
+    parallel_for_dynamic(jobs.size(), num_jobs, [&](size_t const position, unsigned const thread_index) {
+        auto const job_index = order[position];
+        auto& result = results[job_index];
+        result.job = jobs[job_index];
+        auto const estimated_memory = static_cast<size_t>(
+                options.memory_per_input_byte * static_cast<double>(input_sizes[job_index])
+        );
+        budget.acquire(estimated_memory);
+        auto& solver = solvers[thread_index];
+        try {
+            auto const load_start = std::chrono::steady_clock::now();
+            solver.read_graph(result.job.input_path, options.storage);
+            result.load_seconds = seconds_since(load_start);
+            auto const& graph = solver.graph();
+            result.num_nodes = graph.num_nodes();
+            result.num_edges = graph.num_edges();
+
+            auto const solve_start = std::chrono::steady_clock::now();
+            auto const cycle = solver.solve();
+            result.solve_seconds = seconds_since(solve_start);
+            result.num_t_joins = solver.iterations().size();
+            result.acyclic = not cycle;
+            if (cycle) {
+                result.cycle_length = cycle->first.size();
+                result.mean = cycle->second;
+            }
+
+            std::ofstream output(result.job.output_path, std::ios::out | std::ios::trunc);
+            if (not output) {
+                throw std::runtime_error("Failed to open the output file " + result.job.output_path);
+            }
+            write_cycle(
+                    output, graph, cycle,
+                    options.solver.epsilon > 0 ? std::optional<Gamma>(solver.lower_bound()) : std::nullopt
+            );
+            output.flush();
+            if (not output) {
+                throw std::runtime_error("Failed to write the output file " + result.job.output_path);
+            }
+            result.success = true;
+        } catch (std::exception const& xcp) {
+            result.error = xcp.what();
+        }
+        // Only the buffers are kept for the next instance
+        solver.clear_graph();
+        budget.release(estimated_memory);
+    });
+    return results;
+}
+
+void write_batch_summary(std::ostream& output, std::vector<BatchResult> const& results) {
+    output << "input\toutput\tstatus\tnodes\tedges\tcycle_length\tmean\tmean_cost_sum\tmean_num_edges\tt_joins"
+              "\tload_seconds\tsolve_seconds\n";
+    for (auto const& result : results) {
+        output << result.job.input_path << '\t' << result.job.output_path << '\t';
+        if (not result.success) {
+            // Keep the summary one line per job
+            auto error = result.error;
+            std::replace(error.begin(), error.end(), '\t', ' ');
+            std::replace(error.begin(), error.end(), '\n', ' ');
+            output << "error: " << error << "\t\t\t\t\t\t\t\t\t\n";
+            continue;
+        }
+        output << (result.acyclic ? "acyclic" : "ok") << '\t' << result.num_nodes << '\t' << result.num_edges << '\t';
+        if (result.acyclic) {
+            output << "\t\t\t\t";
+        } else {
+            output << result.cycle_length << '\t' << static_cast<double>(result.mean) << '\t' << result.mean.cost_sum
+                   << '\t' << result.mean.num_edges << '\t';
+        }
+        output << result.num_t_joins << '\t' << result.load_seconds << '\t' << result.solve_seconds << '\n';
+    }
+}
+
+}
@@ -0,0 +1,72 @@
+#ifndef MINIMUMMEANCYCLE_BATCHSOLVER_H
+#define MINIMUMMEANCYCLE_BATCHSOLVER_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "graph.h"
+#include "Gamma.h"
+#include "MinimumMeanCycleCalculator.h"
+
+namespace MMC {
+
+/// One instance of a batch: the graph file to read and the file the cycle is written to
+struct BatchJob {
+    std::string input_path;
+    std::string output_path;
+};
+
+struct BatchOptions {
+    MinimumMeanCycleOptions solver{};
+    GraphStorage storage = GraphStorage::sparse;
+    /// Number of instances solved concurrently, 0 means one per hardware thread
+    unsigned num_jobs = 0;
+    /**
+     * Upper bound on the estimated memory of the instances solved concurrently, 0 means no limit. An instance is
+     * estimated to need memory_per_input_byte times the size of its input file. An instance exceeding the limit on its
+     * own is solved while no other instance is running.
+     */
+    size_t memory_limit_bytes = 0;
+    double memory_per_input_byte = 4;
+};
+
+struct BatchResult {
+    BatchJob job;
+    bool success = false;
+    /// Only set if success is false
+    std::string error;
+    NodeId num_nodes = 0;
+    EdgeIndex num_edges = 0;
+    bool acyclic = false;
+    /// Number of edges and mean weight of the minimum mean cycle, unset if acyclic
+    size_t cycle_length = 0;
+    Gamma mean{0, 1};
+    size_t num_t_joins = 0;
+    double load_seconds = 0;
+    double solve_seconds = 0;
+};
+
+/**
+ * Reads a manifest listing one instance per line: the input path, optionally followed by a tab and the output path.
+ * Paths may contain spaces. Relative paths are relative to the directory of the manifest. Without an output path, the
+ * output is written to output_directory, named after the input file with suffix ".out". Empty lines and lines starting
+ * with '#' are skipped. Throws on lines with more than two fields and if two jobs have the same output path.
+ */
+std::vector<BatchJob> read_batch_manifest(std::string const& manifest_path, std::string const& output_directory);
+
+/// One job per regular file in the directory (in lexicographic order), outputs are named as in read_batch_manifest
+std::vector<BatchJob> list_batch_directory(std::string const& input_directory, std::string const& output_directory);
+
+/**
+ * Solves all jobs, writing the cycles in the format of write_cycle. Failures (e.g. unreadable inputs) are reported in
+ * the result of the job and do not stop the other jobs. Larger inputs are started first. Every worker thread reuses one
+ * Solver for all its instances. The results are in the order of the jobs.
+ */
+std::vector<BatchResult> solve_batch(std::vector<BatchJob> const& jobs, BatchOptions const& options);
+
+/// Writes one tab separated line per result, with a header line
+void write_batch_summary(std::ostream& output, std::vector<BatchResult> const& results);
+
+}
+
+#endif //MINIMUMMEANCYCLE_BATCHSOLVER_H
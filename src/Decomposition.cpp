@@ -0,0 +1,158 @@
+#include "Decomposition.h" // always include corresponding header first
+#include <algorithm>
+#include <limits>
+
+namespace MMC {
+
+std::vector<std::vector<EdgeIndex>> find_cyclic_blocks(Graph const& graph) {
+    // Tarjan's algorithm with an explicit stack, the graphs may be too deep for recursion. discovery[v] == 0 means that
+    // v has not been visited yet.
+    struct Frame {
+        NodeId node;
+        EdgeIndex parent_edge;
+        IncidenceIterator next_incidence;
+    };
+    auto const no_edge = std::numeric_limits<EdgeIndex>::max();
+    std::vector<NodeId> discovery(graph.num_nodes(), 0);
+    std::vector<NodeId> low(graph.num_nodes(), 0);
+    std::vector<Frame> stack;
+    std::vector<EdgeIndex> edge_stack;
+    std::vector<std::vector<EdgeIndex>> blocks;
+    NodeId time = 0;
+    for (NodeId root = 0; root < graph.num_nodes(); ++root) {
+        if (discovery[root] != 0) {
+            continue;
+        }
+        discovery[root] = low[root] = ++time;
+        stack.push_back(Frame{root, no_edge, graph.incidences(root).begin()});
+        while (not stack.empty()) {
+            auto& frame = stack.back();
+            auto const node = frame.node;
+            if (frame.next_incidence != graph.incidences(node).end()) {
+                auto const incidence = *frame.next_incidence++;
+                if (incidence.edge == frame.parent_edge) {
+                    continue;
+                }
+                auto const neighbor = incidence.neighbor;
+                if (discovery[neighbor] == 0) {
+                    edge_stack.push_back(incidence.edge);
+                    discovery[neighbor] = low[neighbor] = ++time;
+                    stack.push_back(Frame{neighbor, incidence.edge, graph.incidences(neighbor).begin()});
+                } else if (discovery[neighbor] < discovery[node]) {
+                    // Back edge to an ancestor
+                    edge_stack.push_back(incidence.edge);
+                    low[node] = std::min(low[node], discovery[neighbor]);
+                }
+                continue;
+            }
+            auto const parent_edge = frame.parent_edge;
+            stack.pop_back();
+            if (stack.empty()) {
+                continue;
+            }
+            auto const parent = stack.back().node;
+            low[parent] = std::min(low[parent], low[node]);
+            if (low[node] >= discovery[parent]) {
+                // parent separates the subtree of node, whose edges form a block together with parent_edge
+                auto const block_begin = std::find(edge_stack.rbegin(), edge_stack.rend(), parent_edge).base() - 1;
+                if (edge_stack.end() - block_begin > 1) {
+                    blocks.emplace_back(block_begin, edge_stack.end());
+                    std::sort(blocks.back().begin(), blocks.back().end());
+                }
+                edge_stack.erase(block_begin, edge_stack.end());
+            }
+        }
+    }
+    std::stable_sort(blocks.begin(), blocks.end(), [](auto const& a, auto const& b) { return a.size() > b.size(); });
+    return blocks;
+}
+
+std::vector<std::vector<NodeId>> find_cyclic_strong_components(Digraph const& graph) {
+    // Tarjan's algorithm with an explicit stack like find_cyclic_blocks. discovery[v] == 0 means that v has not been
+    // visited yet, on_stack[v] that v is on the node stack, i.e. its component has not been completed yet.
+    struct Frame {
+        NodeId node;
+        Incidence const* next_arc;
+    };
+    std::vector<NodeId> discovery(graph.num_nodes(), 0);
+    std::vector<NodeId> low(graph.num_nodes(), 0);
+    std::vector<char> on_stack(graph.num_nodes(), false);
+    std::vector<Frame> stack;
+    std::vector<NodeId> node_stack;
+    std::vector<std::vector<NodeId>> components;
+    NodeId time = 0;
+    for (NodeId root = 0; root < graph.num_nodes(); ++root) {
+        if (discovery[root] != 0) {
+            continue;
+        }
+        discovery[root] = low[root] = ++time;
+        on_stack[root] = true;
+        node_stack.push_back(root);
+        stack.push_back(Frame{root, graph.out_arcs(root).begin()});
+        while (not stack.empty()) {
+            auto& frame = stack.back();
+            auto const node = frame.node;
+            if (frame.next_arc != graph.out_arcs(node).end()) {
+                auto const head = frame.next_arc++->neighbor;
+                if (discovery[head] == 0) {
+                    discovery[head] = low[head] = ++time;
+                    on_stack[head] = true;
+                    node_stack.push_back(head);
+                    stack.push_back(Frame{head, graph.out_arcs(head).begin()});
+                } else if (on_stack[head]) {
+                    low[node] = std::min(low[node], discovery[head]);
+                }
+                continue;
+            }
+            stack.pop_back();
+            if (not stack.empty()) {
+                auto const parent = stack.back().node;
+                low[parent] = std::min(low[parent], low[node]);
+            }
+            if (low[node] == discovery[node]) {
+                // node is the root of a component, which consists of the nodes above it on the node stack
+                auto const component_begin = std::find(node_stack.rbegin(), node_stack.rend(), node).base() - 1;
+                for (auto it = component_begin; it != node_stack.end(); ++it) {
+                    on_stack[*it] = false;
+                }
+                if (node_stack.end() - component_begin > 1 or graph.arc_exists(Edge{node, node})) {
+                    components.emplace_back(component_begin, node_stack.end());
+                    std::sort(components.back().begin(), components.back().end());
+                }
+                node_stack.erase(component_begin, node_stack.end());
+            }
+        }
+    }
+    std::stable_sort(components.begin(), components.end(), [](auto const& a, auto const& b) {
+        return a.size() > b.size();
+    });
+    return components;
+}
+
+Subgraph make_subgraph(Graph const& graph, std::vector<EdgeIndex> const& edges) {
+    std::vector<NodeId> original_nodes;
+    original_nodes.reserve(2 * edges.size());
+    for (auto const edge : edges) {
+        original_nodes.push_back(graph.edge(edge).first);
+        original_nodes.push_back(graph.edge(edge).second);
+    }
+    std::sort(original_nodes.begin(), original_nodes.end());
+    original_nodes.erase(std::unique(original_nodes.begin(), original_nodes.end()), original_nodes.end());
+    auto const local_id = [&original_nodes](NodeId const node) {
+        return static_cast<NodeId>(
+                std::lower_bound(original_nodes.begin(), original_nodes.end(), node) - original_nodes.begin()
+        );
+    };
+    std::vector<Edge> local_edges;
+    std::vector<EdgeWeight> weights;
+    local_edges.reserve(edges.size());
+    weights.reserve(edges.size());
+    for (auto const edge : edges) {
+        local_edges.emplace_back(local_id(graph.edge(edge).first), local_id(graph.edge(edge).second));
+        weights.push_back(graph.edge_weight(edge));
+    }
+    auto const num_nodes = static_cast<NodeId>(original_nodes.size());
+    return Subgraph{Graph(num_nodes, std::move(local_edges), weights, graph.storage()), std::move(original_nodes)};
+}
+
+}
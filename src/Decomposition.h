@@ -0,0 +1,37 @@
+#ifndef MINIMUMMEANCYCLE_DECOMPOSITION_H
+#define MINIMUMMEANCYCLE_DECOMPOSITION_H
+
+#include <vector>
+#include "Digraph.h"
+#include "graph.h"
+
+namespace MMC {
+
+/**
+ * Returns the edges of every block (biconnected component) of the graph that contains a cycle, i.e. of every block with
+ * more than one edge. Every cycle of the graph lies in exactly one of them, since a cycle never passes through a bridge
+ * and never leaves a block at an articulation point. The edges of a block are sorted; the blocks are sorted by
+ * decreasing number of edges.
+ */
+[[nodiscard]] std::vector<std::vector<EdgeIndex>> find_cyclic_blocks(Graph const& graph);
+
+/**
+ * Returns the nodes of every strongly connected component of the digraph that contains a cycle, i.e. of every component
+ * with more than one node or with a loop. Every cycle of the digraph lies in exactly one of them. The nodes of a
+ * component are sorted; the components are sorted by decreasing number of nodes.
+ */
+[[nodiscard]] std::vector<std::vector<NodeId>> find_cyclic_strong_components(Digraph const& graph);
+
+/// A part of a graph as a graph of its own
+struct Subgraph {
+    Graph graph;
+    /// Node v of graph is node original_nodes[v] of the original graph. Increasing, so the order of edge ends is kept.
+    std::vector<NodeId> original_nodes;
+};
+
+/// The subgraph formed by the given edges of graph and their ends, stored like graph
+[[nodiscard]] Subgraph make_subgraph(Graph const& graph, std::vector<EdgeIndex> const& edges);
+
+}
+
+#endif //MINIMUMMEANCYCLE_DECOMPOSITION_H
@@ -0,0 +1,357 @@
+#include "DenseKernels.h" // always include corresponding header first
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MMC_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace MMC {
+
+namespace {
+
+KernelIsa& selected_isa() {
+    static KernelIsa isa = best_supported_kernel_isa();
+    return isa;
+}
+
+/// gamma.apply(w) < 0 iff w * num_edges < cost_sum iff w <= floor((cost_sum - 1) / num_edges)
+AccumulatedEdgeWeight negative_weight_threshold(Gamma const gamma) {
+    auto const numerator = gamma.cost_sum - 1;
+    auto const denominator = static_cast<AccumulatedEdgeWeight>(gamma.num_edges);
+    auto quotient = numerator / denominator;
+    if (numerator % denominator != 0 and numerator < 0) {
+        --quotient;
+    }
+    return quotient;
+}
+
+/// Appends the positions of the set bits of mask, offset by first
+template<class Index, class Mask>
+void append_set_bits(Mask mask, size_t const first, std::vector<Index>& output) {
+    while (mask != 0) {
+        output.push_back(static_cast<Index>(first + static_cast<size_t>(__builtin_ctzll(mask))));
+        mask &= mask - 1;
+    }
+}
+
+void find_negative_weights_scalar(
+        EdgeWeight const* weights, size_t const begin, size_t const count, int32_t const threshold,
+        std::vector<EdgeIndex>& negative
+) {
+    for (size_t i = begin; i < count; ++i) {
+        if (weights[i] <= threshold) {
+            negative.push_back(static_cast<EdgeIndex>(i));
+        }
+    }
+}
+
+void find_improving_neighbors_scalar(
+        EdgeWeight const* row, char const* exists, size_t const begin, size_t const count,
+        AccumulatedEdgeWeight const base, Gamma const gamma, AccumulatedEdgeWeight const* distances,
+        std::vector<NodeId>& improved
+) {
+    for (size_t v = begin; v < count; ++v) {
+        if (exists[v] and base + std::abs(gamma.apply(row[v])) < distances[v]) {
+            improved.push_back(static_cast<NodeId>(v));
+        }
+    }
+}
+
+template<class Weight>
+void find_improving_neighbors_sentinel_scalar(
+        Weight const* row, size_t const begin, size_t const count, AccumulatedEdgeWeight const base,
+        Gamma const gamma, AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+) {
+    for (size_t v = begin; v < count; ++v) {
+        if (row[v] != std::numeric_limits<Weight>::min()
+            and base + std::abs(gamma.apply(row[v])) < distances[v]) {
+            improved.push_back(static_cast<NodeId>(v));
+        }
+    }
+}
+
+#ifdef MMC_X86_KERNELS
+
+__attribute__((target("avx2")))
+void find_negative_weights_avx2(
+        EdgeWeight const* weights, size_t const count, int32_t const threshold, std::vector<EdgeIndex>& negative
+) {
+    auto const threshold_vector = _mm256_set1_epi32(threshold);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        auto const weight_vector = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(weights + i));
+        auto const non_negative = _mm256_cmpgt_epi32(weight_vector, threshold_vector);
+        auto const mask = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(non_negative))) & 0xffu;
+        append_set_bits(mask, i, negative);
+    }
+    find_negative_weights_scalar(weights, i, count, threshold, negative);
+}
+
+__attribute__((target("avx512f")))
+void find_negative_weights_avx512(
+        EdgeWeight const* weights, size_t const count, int32_t const threshold, std::vector<EdgeIndex>& negative
+) {
+    auto const threshold_vector = _mm512_set1_epi32(threshold);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        auto const weight_vector = _mm512_loadu_si512(weights + i);
+        append_set_bits(
+                static_cast<unsigned>(_mm512_cmple_epi32_mask(weight_vector, threshold_vector)), i, negative
+        );
+    }
+    find_negative_weights_scalar(weights, i, count, threshold, negative);
+}
+
+// The products row[v] * num_edges are computed with _mm*_mul_epi32 (signed 32 x 32 -> 64 bit), which requires
+// num_edges < 2^31. The callers fall back to the scalar kernel otherwise.
+
+__attribute__((target("avx2")))
+void find_improving_neighbors_avx2(
+        EdgeWeight const* row, char const* exists, size_t const count, AccumulatedEdgeWeight const base,
+        Gamma const gamma, AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+) {
+    auto const num_edges = _mm256_set1_epi64x(static_cast<int64_t>(gamma.num_edges));
+    auto const cost_sum = _mm256_set1_epi64x(gamma.cost_sum);
+    auto const base_vector = _mm256_set1_epi64x(base);
+    auto const zero = _mm256_setzero_si256();
+    size_t v = 0;
+    for (; v + 4 <= count; v += 4) {
+        auto const weights = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const*>(row + v)));
+        auto const transformed = _mm256_sub_epi64(_mm256_mul_epi32(weights, num_edges), cost_sum);
+        auto const absolute = _mm256_blendv_epi8(
+                transformed, _mm256_sub_epi64(zero, transformed), _mm256_cmpgt_epi64(zero, transformed)
+        );
+        auto const candidates = _mm256_add_epi64(base_vector, absolute);
+        auto const current = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(distances + v));
+        int32_t exists_bytes;
+        std::memcpy(&exists_bytes, exists + v, sizeof(exists_bytes));
+        auto const missing = _mm256_cmpeq_epi64(_mm256_cvtepi8_epi64(_mm_cvtsi32_si128(exists_bytes)), zero);
+        auto const better = _mm256_andnot_si256(missing, _mm256_cmpgt_epi64(current, candidates));
+        append_set_bits(static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(better))), v, improved);
+    }
+    find_improving_neighbors_scalar(row, exists, v, count, base, gamma, distances, improved);
+}
+
+__attribute__((target("avx512f")))
+void find_improving_neighbors_avx512(
+        EdgeWeight const* row, char const* exists, size_t const count, AccumulatedEdgeWeight const base,
+        Gamma const gamma, AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+) {
+    // The zero-masking forms are used with a full mask, as the unmasked ones trigger false -Wmaybe-uninitialized
+    // warnings in the headers of GCC 12
+    __mmask8 const all = 0xff;
+    auto const num_edges = _mm512_set1_epi64(static_cast<int64_t>(gamma.num_edges));
+    auto const cost_sum = _mm512_set1_epi64(gamma.cost_sum);
+    auto const base_vector = _mm512_set1_epi64(base);
+    size_t v = 0;
+    for (; v + 8 <= count; v += 8) {
+        auto const weights = _mm512_maskz_cvtepi32_epi64(
+                all, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(row + v))
+        );
+        auto const transformed = _mm512_sub_epi64(_mm512_maskz_mul_epi32(all, weights, num_edges), cost_sum);
+        auto const candidates = _mm512_add_epi64(base_vector, _mm512_maskz_abs_epi64(all, transformed));
+        auto const current = _mm512_loadu_si512(distances + v);
+        auto const exists_vector = _mm512_maskz_cvtepi8_epi64(
+                all, _mm_loadl_epi64(reinterpret_cast<__m128i const*>(exists + v))
+        );
+        auto const better = _mm512_mask_cmpgt_epi64_mask(
+                _mm512_test_epi64_mask(exists_vector, exists_vector), current, candidates
+        );
+        append_set_bits(static_cast<unsigned>(better), v, improved);
+    }
+    find_improving_neighbors_scalar(row, exists, v, count, base, gamma, distances, improved);
+}
+
+template<class Weight>
+__attribute__((target("avx2")))
+void find_improving_neighbors_sentinel_avx2(
+        Weight const* row, size_t const count, AccumulatedEdgeWeight const base, Gamma const gamma,
+        AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+) {
+    auto const num_edges = _mm256_set1_epi64x(static_cast<int64_t>(gamma.num_edges));
+    auto const cost_sum = _mm256_set1_epi64x(gamma.cost_sum);
+    auto const base_vector = _mm256_set1_epi64x(base);
+    auto const sentinel = _mm256_set1_epi64x(std::numeric_limits<Weight>::min());
+    auto const zero = _mm256_setzero_si256();
+    size_t v = 0;
+    for (; v + 4 <= count; v += 4) {
+        __m256i weights;
+        if constexpr (sizeof(Weight) == 2) {
+            weights = _mm256_cvtepi16_epi64(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(row + v)));
+        } else {
+            weights = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const*>(row + v)));
+        }
+        auto const transformed = _mm256_sub_epi64(_mm256_mul_epi32(weights, num_edges), cost_sum);
+        auto const absolute = _mm256_blendv_epi8(
+                transformed, _mm256_sub_epi64(zero, transformed), _mm256_cmpgt_epi64(zero, transformed)
+        );
+        auto const candidates = _mm256_add_epi64(base_vector, absolute);
+        auto const current = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(distances + v));
+        auto const missing = _mm256_cmpeq_epi64(weights, sentinel);
+        auto const better = _mm256_andnot_si256(missing, _mm256_cmpgt_epi64(current, candidates));
+        append_set_bits(static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(better))), v, improved);
+    }
+    find_improving_neighbors_sentinel_scalar(row, v, count, base, gamma, distances, improved);
+}
+
+template<class Weight>
+__attribute__((target("avx512f")))
+void find_improving_neighbors_sentinel_avx512(
+        Weight const* row, size_t const count, AccumulatedEdgeWeight const base, Gamma const gamma,
+        AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+) {
+    __mmask8 const all = 0xff;
+    auto const num_edges = _mm512_set1_epi64(static_cast<int64_t>(gamma.num_edges));
+    auto const cost_sum = _mm512_set1_epi64(gamma.cost_sum);
+    auto const base_vector = _mm512_set1_epi64(base);
+    auto const sentinel = _mm512_set1_epi64(std::numeric_limits<Weight>::min());
+    size_t v = 0;
+    for (; v + 8 <= count; v += 8) {
+        __m512i weights;
+        if constexpr (sizeof(Weight) == 2) {
+            weights = _mm512_maskz_cvtepi16_epi64(all, _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + v)));
+        } else {
+            weights = _mm512_maskz_cvtepi32_epi64(
+                    all, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(row + v))
+            );
+        }
+        auto const transformed = _mm512_sub_epi64(_mm512_maskz_mul_epi32(all, weights, num_edges), cost_sum);
+        auto const candidates = _mm512_add_epi64(base_vector, _mm512_maskz_abs_epi64(all, transformed));
+        auto const current = _mm512_loadu_si512(distances + v);
+        auto const better = _mm512_mask_cmpgt_epi64_mask(
+                _mm512_cmpneq_epi64_mask(weights, sentinel), current, candidates
+        );
+        append_set_bits(static_cast<unsigned>(better), v, improved);
+    }
+    find_improving_neighbors_sentinel_scalar(row, v, count, base, gamma, distances, improved);
+}
+
+#endif
+
+template<class Weight>
+void find_improving_neighbors_sentinel(
+        Weight const* row, size_t const count, AccumulatedEdgeWeight const base, Gamma const gamma,
+        AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+) {
+    auto const isa = gamma.num_edges <= static_cast<size_t>(std::numeric_limits<int32_t>::max()) ?
+                     kernel_isa() : KernelIsa::scalar;
+    switch (isa) {
+#ifdef MMC_X86_KERNELS
+        case KernelIsa::avx512:
+            find_improving_neighbors_sentinel_avx512(row, count, base, gamma, distances, improved);
+            return;
+        case KernelIsa::avx2:
+            find_improving_neighbors_sentinel_avx2(row, count, base, gamma, distances, improved);
+            return;
+#endif
+        default:
+            find_improving_neighbors_sentinel_scalar(row, 0, count, base, gamma, distances, improved);
+    }
+}
+
+} // end of anonymous namespace
+
+KernelIsa kernel_isa() {
+    return selected_isa();
+}
+
+KernelIsa best_supported_kernel_isa() {
+#ifdef MMC_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return KernelIsa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return KernelIsa::avx2;
+    }
+#endif
+    return KernelIsa::scalar;
+}
+
+void set_kernel_isa(KernelIsa const isa) {
+    if (static_cast<int>(isa) > static_cast<int>(best_supported_kernel_isa())) {
+        throw std::runtime_error(std::string("The CPU does not support ") + to_string(isa));
+    }
+    selected_isa() = isa;
+}
+
+char const* to_string(KernelIsa const isa) {
+    switch (isa) {
+        case KernelIsa::scalar:
+            return "scalar";
+        case KernelIsa::avx2:
+            return "avx2";
+        case KernelIsa::avx512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+void find_negative_weights(
+        EdgeWeight const* weights, size_t const count, Gamma const gamma, std::vector<EdgeIndex>& negative
+) {
+    auto const threshold = negative_weight_threshold(gamma);
+    if (threshold < std::numeric_limits<int32_t>::min()) {
+        return;
+    }
+    if (threshold >= std::numeric_limits<int32_t>::max()) {
+        for (size_t i = 0; i < count; ++i) {
+            negative.push_back(static_cast<EdgeIndex>(i));
+        }
+        return;
+    }
+    auto const threshold32 = static_cast<int32_t>(threshold);
+    switch (kernel_isa()) {
+#ifdef MMC_X86_KERNELS
+        case KernelIsa::avx512:
+            find_negative_weights_avx512(weights, count, threshold32, negative);
+            return;
+        case KernelIsa::avx2:
+            find_negative_weights_avx2(weights, count, threshold32, negative);
+            return;
+#endif
+        default:
+            find_negative_weights_scalar(weights, 0, count, threshold32, negative);
+    }
+}
+
+void find_improving_neighbors(
+        EdgeWeight const* row, char const* exists, size_t const count, AccumulatedEdgeWeight const base,
+        Gamma const gamma, AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+) {
+    auto const isa = gamma.num_edges <= static_cast<size_t>(std::numeric_limits<int32_t>::max()) ?
+                     kernel_isa() : KernelIsa::scalar;
+    switch (isa) {
+#ifdef MMC_X86_KERNELS
+        case KernelIsa::avx512:
+            find_improving_neighbors_avx512(row, exists, count, base, gamma, distances, improved);
+            return;
+        case KernelIsa::avx2:
+            find_improving_neighbors_avx2(row, exists, count, base, gamma, distances, improved);
+            return;
+#endif
+        default:
+            find_improving_neighbors_scalar(row, exists, 0, count, base, gamma, distances, improved);
+    }
+}
+
+void find_improving_neighbors(
+        int16_t const* row, size_t const count, AccumulatedEdgeWeight const base, Gamma const gamma,
+        AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+) {
+    find_improving_neighbors_sentinel(row, count, base, gamma, distances, improved);
+}
+
+void find_improving_neighbors(
+        int32_t const* row, size_t const count, AccumulatedEdgeWeight const base, Gamma const gamma,
+        AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+) {
+    find_improving_neighbors_sentinel(row, count, base, gamma, distances, improved);
+}
+
+}
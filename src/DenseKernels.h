@@ -0,0 +1,63 @@
+#ifndef MINIMUMMEANCYCLE_DENSEKERNELS_H
+#define MINIMUMMEANCYCLE_DENSEKERNELS_H
+
+#include <vector>
+#include "graph.h"
+#include "Gamma.h"
+
+namespace MMC {
+
+/**
+ * @file DenseKernels.h
+ *
+ * Loops over contiguous weight arrays that dominate the running time on dense graphs. Each kernel has a scalar version
+ * and AVX2 and AVX-512 versions; the best one supported by the CPU is selected at runtime, so the binary does not have
+ * to be compiled for a specific instruction set.
+ */
+
+enum class KernelIsa {
+    scalar,
+    avx2,
+    avx512,
+};
+
+/// The instruction set used by the kernels
+[[nodiscard]] KernelIsa kernel_isa();
+
+/// The best instruction set supported by the CPU
+[[nodiscard]] KernelIsa best_supported_kernel_isa();
+
+/// Selects the instruction set used by the kernels, e.g. to compare them. Throws if the CPU does not support it.
+void set_kernel_isa(KernelIsa isa);
+
+[[nodiscard]] char const* to_string(KernelIsa isa);
+
+/// Appends every i in [0, count) with gamma.apply(weights[i]) < 0 to negative, in increasing order
+void find_negative_weights(
+        EdgeWeight const* weights, size_t count, Gamma gamma, std::vector<EdgeIndex>& negative
+);
+
+/**
+ * Relaxation of all edges of one row of an adjacency matrix: appends every v in [0, count) with exists[v] != 0 and
+ * base + abs(gamma.apply(row[v])) < distances[v] to improved, in increasing order. The distances are not changed.
+ */
+void find_improving_neighbors(
+        EdgeWeight const* row, char const* exists, size_t count, AccumulatedEdgeWeight base, Gamma gamma,
+        AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+);
+
+/// Like find_improving_neighbors, for a row of a compact matrix in which missing edges have the minimum weight of the
+/// type (see GraphStorage::compact_dense)
+void find_improving_neighbors(
+        int16_t const* row, size_t count, AccumulatedEdgeWeight base, Gamma gamma,
+        AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+);
+
+void find_improving_neighbors(
+        int32_t const* row, size_t count, AccumulatedEdgeWeight base, Gamma gamma,
+        AccumulatedEdgeWeight const* distances, std::vector<NodeId>& improved
+);
+
+}
+
+#endif //MINIMUMMEANCYCLE_DENSEKERNELS_H
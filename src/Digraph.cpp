@@ -0,0 +1,75 @@
+#include "Digraph.h" // always include corresponding header first
+#include <algorithm>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include "DimacsParser.h"
+#include "MappedFile.h"
+
+namespace MMC {
+
+Digraph::Digraph(NodeId const num_nodes, std::vector<Edge> arcs, std::vector<EdgeWeight> const& weights)
+        : _num_nodes(num_nodes),
+          _offsets(num_nodes + 1, 0) {
+    assert(arcs.size() == weights.size());
+    for (auto const& arc : arcs) {
+        if (arc.first >= num_nodes or arc.second >= num_nodes) {
+            throw std::runtime_error("Arc end is not a node of the digraph!");
+        }
+    }
+    // Sort the arcs lexicographically, cheapest first among parallel ones, which makes the out-arcs of every node
+    // contiguous and sorted by head
+    std::vector<EdgeIndex> order(arcs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&arcs, &weights](EdgeIndex const a, EdgeIndex const b) {
+        return arcs[a] < arcs[b] or (arcs[a] == arcs[b] and weights[a] < weights[b]);
+    });
+    _arcs.reserve(arcs.size());
+    _arc_weights.reserve(arcs.size());
+    for (auto const index : order) {
+        if (_arcs.empty() or _arcs.back() != arcs[index]) {
+            _arcs.push_back(arcs[index]);
+            _arc_weights.push_back(weights[index]);
+        }
+    }
+    for (auto const& arc : _arcs) {
+        ++_offsets[arc.first + 1];
+    }
+    std::partial_sum(_offsets.begin(), _offsets.end(), _offsets.begin());
+    _incidences.reserve(_arcs.size());
+    for (EdgeIndex i = 0; i < _arcs.size(); ++i) {
+        _incidences.push_back(Incidence{_arcs[i].second, _arc_weights[i], i});
+    }
+}
+
+Incidence const* Digraph::find_incidence(Edge const& arc) const {
+    auto const range = out_arcs(arc.first);
+    auto const it = std::lower_bound(
+            range.begin(), range.end(), arc.second,
+            [](Incidence const& incidence, NodeId const node) { return incidence.neighbor < node; }
+    );
+    if (it == range.end() or it->neighbor != arc.second) {
+        return nullptr;
+    }
+    return it;
+}
+
+Digraph Digraph::read_dimacs(std::istream& input) {
+    auto lines = read_dimacs_lines(input);
+    return Digraph(lines.num_nodes, std::move(lines.edges), lines.weights);
+}
+
+Digraph Digraph::read_dimacs_file(std::string const& path, unsigned const num_threads) {
+    MappedFile const file(path);
+    auto lines = parse_dimacs_lines(file.data(), file.data() + file.size(), 'a', num_threads);
+    return Digraph(lines.num_nodes, std::move(lines.edges), lines.weights);
+}
+
+void Digraph::write_dimacs(std::ostream& output) const {
+    output << "p sp " << _num_nodes << ' ' << _arcs.size() << '\n';
+    for (EdgeIndex i = 0; i < _arcs.size(); ++i) {
+        output << "a " << _arcs[i].first + 1 << ' ' << _arcs[i].second + 1 << ' ' << _arc_weights[i] << '\n';
+    }
+}
+
+}
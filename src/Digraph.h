@@ -0,0 +1,94 @@
+#ifndef MINIMUMMEANCYCLE_DIGRAPH_H
+#define MINIMUMMEANCYCLE_DIGRAPH_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "graph.h"
+
+namespace MMC {
+
+/**
+ * A weighted directed graph, stored like the sparse storage of Graph: a sorted arc list and the outgoing arcs of every
+ * node in compressed sparse row (CSR) format, i.e. the arcs leaving node v are stored at positions
+ * [_offsets[v], _offsets[v + 1]) of _incidences. An arc is an Edge (tail, head); loops are allowed.
+ */
+class Digraph {
+public:
+    /**
+     * Creates a digraph with num_nodes nodes and the given arcs, weights[i] is the weight of arcs[i]. Of parallel
+     * arcs only the cheapest is kept, since no minimum mean cycle needs the others.
+     */
+    Digraph(NodeId num_nodes, std::vector<Edge> arcs, std::vector<EdgeWeight> const& weights);
+
+    [[nodiscard]] NodeId num_nodes() const;
+
+    [[nodiscard]] EdgeIndex num_arcs() const;
+
+    /// The arcs are sorted lexicographically by (tail, head)
+    [[nodiscard]] Edge const& arc(EdgeIndex index) const;
+
+    [[nodiscard]] EdgeWeight arc_weight(EdgeIndex index) const;
+
+    /// The arcs leaving node, sorted by head. The neighbor of an incidence is the head of the arc.
+    [[nodiscard]] ArrayRange<Incidence> out_arcs(NodeId node) const;
+
+    [[nodiscard]] bool arc_exists(Edge const& arc) const;
+
+    /// The weight of an existing arc, in time O(log(out-degree of its tail))
+    [[nodiscard]] EdgeWeight arc_cost(Edge const& arc) const;
+
+    /// Reads a digraph in DIMACS arc format: "p sp <num nodes> <num arcs>" followed by lines "a <tail> <head> <weight>"
+    static Digraph read_dimacs(std::istream& input);
+
+    /// Equivalent to read_dimacs, but maps the file into memory and parses it with up to num_threads threads
+    static Digraph read_dimacs_file(std::string const& path, unsigned num_threads = 1);
+
+    /// Writes the digraph in DIMACS arc format, as read by read_dimacs
+    void write_dimacs(std::ostream& output) const;
+
+private:
+    /// Returns the incidence of the arc in the list of its tail, or nullptr if the arc does not exist
+    [[nodiscard]] Incidence const* find_incidence(Edge const& arc) const;
+
+    NodeId const _num_nodes;
+    std::vector<Edge> _arcs;
+    std::vector<EdgeWeight> _arc_weights;
+    /// Size num_nodes + 1
+    std::vector<size_t> _offsets;
+    /// Size num_arcs, in the order of the arcs
+    std::vector<Incidence> _incidences;
+};
+
+inline NodeId Digraph::num_nodes() const {
+    return _num_nodes;
+}
+
+inline EdgeIndex Digraph::num_arcs() const {
+    return static_cast<EdgeIndex>(_arcs.size());
+}
+
+inline Edge const& Digraph::arc(EdgeIndex const index) const {
+    return _arcs[index];
+}
+
+inline EdgeWeight Digraph::arc_weight(EdgeIndex const index) const {
+    return _arc_weights[index];
+}
+
+inline ArrayRange<Incidence> Digraph::out_arcs(NodeId const node) const {
+    return {_incidences.data() + _offsets[node], _incidences.data() + _offsets[node + 1]};
+}
+
+inline bool Digraph::arc_exists(Edge const& arc) const {
+    return find_incidence(arc) != nullptr;
+}
+
+inline EdgeWeight Digraph::arc_cost(Edge const& arc) const {
+    assert(arc_exists(arc));
+    return find_incidence(arc)->weight;
+}
+
+}
+
+#endif //MINIMUMMEANCYCLE_DIGRAPH_H
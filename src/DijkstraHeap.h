@@ -0,0 +1,134 @@
+#ifndef MINIMUMMEANCYCLE_DIJKSTRAHEAP_H
+#define MINIMUMMEANCYCLE_DIJKSTRAHEAP_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "graph.h"
+
+namespace MMC {
+
+/**
+ * @file DijkstraHeap.h
+ *
+ * Priority queues usable as the Heap policy of BasicShortestPathCalculator. A policy provides push(node, distance),
+ * empty(), top(), pop() and clear(). Nodes are not updated in place: a node whose distance decreases is pushed again
+ * and the calculator skips the outdated entries. clear() has to keep the allocated memory, so that a heap can be reused
+ * by consecutive calculators.
+ */
+
+struct HeapEntry {
+    NodeId node;
+    AccumulatedEdgeWeight distance;
+
+    bool operator>(HeapEntry const& other) const {
+        return distance > other.distance;
+    }
+};
+
+/// Binary min-heap managed with std::push_heap/std::pop_heap. Works for arbitrary push orders.
+class BinaryHeap {
+public:
+    void push(NodeId const node, AccumulatedEdgeWeight const distance) {
+        _entries.push_back(HeapEntry{node, distance});
+        std::push_heap(_entries.begin(), _entries.end(), std::greater<>{});
+    }
+
+    [[nodiscard]] bool empty() const {
+        return _entries.empty();
+    }
+
+    HeapEntry const& top() {
+        return _entries.front();
+    }
+
+    void pop() {
+        std::pop_heap(_entries.begin(), _entries.end(), std::greater<>{});
+        _entries.pop_back();
+    }
+
+    void clear() {
+        _entries.clear();
+    }
+
+private:
+    std::vector<HeapEntry> _entries;
+};
+
+/**
+ * Radix heap for non-negative integer distances that are pushed monotonically, i.e. never below the last extracted
+ * distance, as in Dijkstra's algorithm with non-negative weights. Entries are kept in buckets by the highest bit in
+ * which their distance differs from the last extracted one. Pushing is O(1); an entry is moved to a lower bucket at
+ * most 64 times in total, instead of the O(log(heap size)) comparisons per push and pop of a binary heap.
+ */
+class RadixHeap {
+public:
+    void push(NodeId const node, AccumulatedEdgeWeight const distance) {
+        assert(distance >= _last);
+        _buckets[bucket_index(distance)].push_back(HeapEntry{node, distance});
+        ++_size;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return _size == 0;
+    }
+
+    /// Not const, because the smallest entries may have to be moved to the first bucket first
+    HeapEntry const& top() {
+        assert(not empty());
+        if (_buckets.front().empty()) {
+            refill_first_bucket();
+        }
+        return _buckets.front().back();
+    }
+
+    void pop() {
+        top();
+        _buckets.front().pop_back();
+        --_size;
+    }
+
+    void clear() {
+        for (auto& bucket : _buckets) {
+            bucket.clear();
+        }
+        _last = 0;
+        _size = 0;
+    }
+
+private:
+    static constexpr size_t num_buckets = 65;
+
+    /// 0 for distance == _last, otherwise one plus the index of the highest bit in which distance and _last differ
+    [[nodiscard]] size_t bucket_index(AccumulatedEdgeWeight const distance) const {
+        auto const difference = static_cast<uint64_t>(distance ^ _last);
+        return difference == 0 ? 0 : 64 - static_cast<size_t>(__builtin_clzll(difference));
+    }
+
+    /// Makes the minimum of the first non-empty bucket the new _last, which spreads that bucket over lower buckets
+    void refill_first_bucket() {
+        auto bucket = std::find_if(_buckets.begin() + 1, _buckets.end(), [](auto const& entries) {
+            return not entries.empty();
+        });
+        assert(bucket != _buckets.end());
+        _last = std::min_element(bucket->begin(), bucket->end(), [](HeapEntry const& a, HeapEntry const& b) {
+            return a.distance < b.distance;
+        })->distance;
+        for (auto const& entry : *bucket) {
+            _buckets[bucket_index(entry.distance)].push_back(entry);
+        }
+        bucket->clear();
+    }
+
+    std::array<std::vector<HeapEntry>, num_buckets> _buckets;
+    /// The last extracted distance, a lower bound on all distances in the heap
+    AccumulatedEdgeWeight _last = 0;
+    size_t _size = 0;
+};
+
+}
+
+#endif //MINIMUMMEANCYCLE_DIJKSTRAHEAP_H
@@ -0,0 +1,232 @@
+#include "DimacsParser.h" // always include corresponding header first
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "Parallel.h"
+
+namespace MMC {
+
+namespace {
+
+NodeId from_dimacs_id(size_type dimacs_node_id) {
+    if (dimacs_node_id <= 0) {
+        throw std::runtime_error("Non-positive DIMACS node id can not be converted.");
+    }
+    return NodeId(dimacs_node_id - 1);
+}
+
+// Returns the first line which is not a comment, i.e. does not start with c.
+std::string read_next_non_comment_line(std::istream& input) {
+    std::string line;
+    do {
+        if (!std::getline(input, line)) {
+            throw std::runtime_error("Unexpected end of DIMACS stream.");
+        }
+    } while (line[0] == 'c');
+    return line;
+}
+
+/// Skips spaces and tabs
+char const* skip_blanks(char const* position, char const* const end) {
+    while (position != end and (*position == ' ' or *position == '\t')) {
+        ++position;
+    }
+    return position;
+}
+
+char const* find_line_end(char const* position, char const* const end) {
+    while (position != end and *position != '\n') {
+        ++position;
+    }
+    return position;
+}
+
+/// Parses a decimal integer (possibly preceded by blanks and a sign) starting at position. Returns false on failure.
+bool parse_integer(char const*& position, char const* const end, int64_t& value) {
+    position = skip_blanks(position, end);
+    bool negative = false;
+    if (position != end and (*position == '-' or *position == '+')) {
+        negative = *position == '-';
+        ++position;
+    }
+    if (position == end or *position < '0' or *position > '9') {
+        return false;
+    }
+    uint64_t magnitude = 0;
+    auto const max_magnitude = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+    for (; position != end and *position >= '0' and *position <= '9'; ++position) {
+        auto const digit = static_cast<uint64_t>(*position - '0');
+        // Checked before multiplying, afterwards the value may already have wrapped around
+        if (magnitude > (max_magnitude - digit) / 10) {
+            return false;
+        }
+        magnitude = 10 * magnitude + digit;
+    }
+    value = negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+    return true;
+}
+
+std::runtime_error invalid_line_error(char const* line_begin, char const* line_end) {
+    return std::runtime_error("Invalid data in DIMACS line: " + std::string(line_begin, line_end));
+}
+
+/// Edges read from one chunk of the edge lines of a DIMACS file
+struct ParsedEdges {
+    std::vector<Edge> edges;
+    std::vector<EdgeWeight> weights;
+    /// The first invalid line of the chunk, parsing stopped there. Both are nullptr if all lines are valid.
+    char const* invalid_line_begin = nullptr;
+    char const* invalid_line_end = nullptr;
+};
+
+/// Parses all lines in [begin, end), which has to start at the beginning of a line. Comment and empty lines are skipped,
+/// all other lines have to be edge lines of the given type. Stops at the first invalid line instead of throwing, since
+/// the line is only an error if it does not come after the announced number of edges.
+void parse_edge_lines(
+        char const* begin, char const* const end, char const line_type, size_type const num_nodes, ParsedEdges& result
+) {
+    while (begin != end) {
+        auto const line_end = find_line_end(begin, end);
+        auto position = skip_blanks(begin, line_end);
+        if (position != line_end and *position != 'c' and *position != '\r') {
+            if (*position != line_type) {
+                result.invalid_line_begin = begin;
+                result.invalid_line_end = line_end;
+                return;
+            }
+            ++position;
+            int64_t dimacs_node1{};
+            int64_t dimacs_node2{};
+            int64_t weight{};
+            if (not parse_integer(position, line_end, dimacs_node1) or
+                not parse_integer(position, line_end, dimacs_node2) or
+                not parse_integer(position, line_end, weight) or
+                dimacs_node1 < 1 or dimacs_node1 > num_nodes or
+                dimacs_node2 < 1 or dimacs_node2 > num_nodes or
+                weight < std::numeric_limits<EdgeWeight>::min() or weight > std::numeric_limits<EdgeWeight>::max()) {
+                result.invalid_line_begin = begin;
+                result.invalid_line_end = line_end;
+                return;
+            }
+            result.edges.emplace_back(from_dimacs_id(dimacs_node1), from_dimacs_id(dimacs_node2));
+            result.weights.push_back(static_cast<EdgeWeight>(weight));
+        }
+        begin = line_end == end ? end : line_end + 1;
+    }
+}
+
+} // end of anonymous namespace
+
+DimacsLines read_dimacs_lines(std::istream& input) {
+    std::string unused_word{};
+    std::string const first_line = read_next_non_comment_line(input);
+
+    if (first_line[0] != 'p') {
+        throw std::runtime_error("Unexpected format of input file!");
+    }
+
+    size_type num_nodes{};
+    size_type num_edges{};
+    std::stringstream first_buffering_stream{first_line};
+    first_buffering_stream >> unused_word >> unused_word >> num_nodes >> num_edges;
+    if (not first_buffering_stream) {
+        throw std::runtime_error("Invalid first line in DIMACS: " + first_line);
+    }
+
+    // Now we successively collect the edges
+    DimacsLines result{NodeId{num_nodes}, {}, {}};
+    result.edges.reserve(num_edges);
+    result.weights.reserve(num_edges);
+    for (size_type i = 1; i <= num_edges; ++i) {
+        std::string const ith_line = read_next_non_comment_line(input);
+        size_type dimacs_node1{};
+        size_type dimacs_node2{};
+        EdgeWeight weight{};
+        std::stringstream ith_buffering_stream{ith_line};
+        ith_buffering_stream >> unused_word >> dimacs_node1 >> dimacs_node2 >> weight;
+        if (not ith_buffering_stream or
+            dimacs_node1 < 1 or dimacs_node1 > num_nodes or
+            dimacs_node2 < 1 or dimacs_node2 > num_nodes) {
+            throw std::runtime_error("Invalid data in DIMACS line: " + ith_line);
+        }
+        result.edges.emplace_back(from_dimacs_id(dimacs_node1), from_dimacs_id(dimacs_node2));
+        result.weights.push_back(weight);
+    }
+    return result;
+}
+
+DimacsLines parse_dimacs_lines(
+        char const* position, char const* const end, char const line_type, unsigned const num_threads
+) {
+    // Skip comments until the problem line
+    char const* line_end = position;
+    while (true) {
+        if (position == end) {
+            throw std::runtime_error("Unexpected end of DIMACS stream.");
+        }
+        line_end = find_line_end(position, end);
+        if (*position != 'c') {
+            break;
+        }
+        position = line_end == end ? end : line_end + 1;
+    }
+    std::string const first_line(position, line_end);
+    if (first_line.empty() or first_line[0] != 'p') {
+        throw std::runtime_error("Unexpected format of input file!");
+    }
+    std::stringstream first_buffering_stream{first_line};
+    std::string unused_word{};
+    size_type num_nodes{};
+    size_type num_edges{};
+    first_buffering_stream >> unused_word >> unused_word >> num_nodes >> num_edges;
+    if (not first_buffering_stream) {
+        throw std::runtime_error("Invalid first line in DIMACS: " + first_line);
+    }
+    char const* const body = line_end == end ? end : line_end + 1;
+
+    // Split the edge lines into chunks ending at line boundaries. Using more chunks than threads balances the load.
+    auto const used_threads = resolve_num_threads(num_threads);
+    size_t const num_chunks = used_threads == 1 ? 1 : 4 * used_threads;
+    std::vector<char const*> chunk_begins{body};
+    for (size_t i = 1; i < num_chunks; ++i) {
+        auto const target = body + static_cast<size_t>(end - body) * i / num_chunks;
+        auto const chunk_begin = std::max(chunk_begins.back(), target);
+        auto const next_line_end = find_line_end(chunk_begin, end);
+        chunk_begins.push_back(next_line_end == end ? end : next_line_end + 1);
+    }
+    chunk_begins.push_back(end);
+    std::vector<ParsedEdges> chunks(num_chunks);
+    parallel_for_dynamic(num_chunks, used_threads, [&](size_t const chunk, unsigned) {
+        parse_edge_lines(chunk_begins[chunk], chunk_begins[chunk + 1], line_type, num_nodes, chunks[chunk]);
+    });
+
+    // Concatenate the chunks in file order. As in read_dimacs_lines, lines after the announced number of edges are
+    // ignored, even if they are invalid, so an invalid line is only reported if edges are still missing after it.
+    DimacsLines result{NodeId{num_nodes}, {}, {}};
+    auto& edges = result.edges;
+    auto& weights = result.weights;
+    edges.reserve(num_edges);
+    weights.reserve(num_edges);
+    for (auto& chunk : chunks) {
+        auto const num_taken = std::min(chunk.edges.size(), num_edges - edges.size());
+        edges.insert(edges.end(), chunk.edges.begin(), chunk.edges.begin() + num_taken);
+        weights.insert(weights.end(), chunk.weights.begin(), chunk.weights.begin() + num_taken);
+        if (edges.size() == num_edges) {
+            break;
+        }
+        if (chunk.invalid_line_begin != nullptr) {
+            throw invalid_line_error(chunk.invalid_line_begin, chunk.invalid_line_end);
+        }
+        chunk = ParsedEdges{};
+    }
+    if (edges.size() < num_edges) {
+        throw std::runtime_error("Unexpected end of DIMACS stream.");
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef MINIMUMMEANCYCLE_DIMACSPARSER_H
+#define MINIMUMMEANCYCLE_DIMACSPARSER_H
+
+#include <iosfwd>
+#include <vector>
+#include "graph.h"
+
+namespace MMC {
+
+/// The contents of a DIMACS file: the number of nodes of the problem line and the pairs and weights of the edge lines
+struct DimacsLines {
+    NodeId num_nodes;
+    std::vector<Edge> edges;
+    std::vector<EdgeWeight> weights;
+};
+
+/**
+ * Reads a DIMACS graph from a stream: comment lines starting with c, the problem line "p <format> <num nodes>
+ * <num lines>" and that many lines "<type> <node> <node> <weight>" with 1-based node IDs. Neither the format nor the
+ * type of the lines is checked. Lines after the announced number of lines are ignored.
+ */
+[[nodiscard]] DimacsLines read_dimacs_lines(std::istream& input);
+
+/**
+ * Like read_dimacs_lines, but parses the file contents [begin, end) in place, and the lines between the problem line and
+ * the last announced edge line have to be comments, empty or of the given line_type ('e' for edges, 'a' for arcs). The
+ * lines are split into chunks at line boundaries that are parsed by up to num_threads threads (0 means one per hardware
+ * thread).
+ */
+[[nodiscard]] DimacsLines parse_dimacs_lines(char const* begin, char const* end, char line_type, unsigned num_threads);
+
+}
+
+#endif //MINIMUMMEANCYCLE_DIMACSPARSER_H
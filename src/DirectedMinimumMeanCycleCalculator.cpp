@@ -0,0 +1,347 @@
+#include "DirectedMinimumMeanCycleCalculator.h" // always include corresponding header first
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include "Decomposition.h"
+#include "Parallel.h"
+
+namespace MMC {
+
+namespace {
+
+__extension__ using Int128 = __int128;
+
+constexpr NodeId no_component = std::numeric_limits<NodeId>::max();
+
+/// Karp's algorithm stores two tables with this many entries at most, i.e. about 1.5 GB
+constexpr size_t max_karp_table_size = size_t{1} << 27;
+
+/// Exact comparison of two means. Unlike Gamma::operator<, it does not overflow for long cycles of heavy arcs.
+bool is_less(Gamma const& a, Gamma const& b) {
+    return static_cast<Int128>(a.cost_sum) * static_cast<Int128>(b.num_edges)
+           < static_cast<Int128>(b.cost_sum) * static_cast<Int128>(a.num_edges);
+}
+
+/// The weight of an arc minus the mean, scaled by the denominator of the mean as in Gamma::apply
+Int128 reduced_cost(EdgeWeight const weight, Gamma const& mean) {
+    return static_cast<Int128>(weight) * static_cast<Int128>(mean.num_edges) - mean.cost_sum;
+}
+
+/// An arc of a component, from or to node depending on the adjacency list it is in
+struct LocalArc {
+    NodeId node;
+    EdgeWeight weight;
+};
+
+/// A strongly connected component with the nodes numbered by their position in the sorted nodes of the component
+struct ComponentGraph {
+    NodeId num_nodes;
+    /// The arcs leaving every node in CSR format, with the head as node
+    std::vector<size_t> out_offsets;
+    std::vector<LocalArc> out_arcs;
+    /// The arcs entering every node in CSR format, with the tail as node. Only built for Howard's algorithm.
+    std::vector<size_t> in_offsets;
+    std::vector<LocalArc> in_arcs;
+
+    [[nodiscard]] ArrayRange<LocalArc> out(NodeId const node) const {
+        return {out_arcs.data() + out_offsets[node], out_arcs.data() + out_offsets[node + 1]};
+    }
+
+    [[nodiscard]] ArrayRange<LocalArc> in(NodeId const node) const {
+        return {in_arcs.data() + in_offsets[node], in_arcs.data() + in_offsets[node + 1]};
+    }
+};
+
+/// A cycle of a component as its nodes in the order of the cycle, and its mean in lowest terms
+using LocalCycle = std::pair<std::vector<NodeId>, Gamma>;
+
+/**
+ * The component with the given nodes. component[v] is the index of the component of node v and local_id[v] the
+ * position of v in the nodes of its component.
+ */
+ComponentGraph make_component_graph(
+        Digraph const& graph, std::vector<NodeId> const& nodes, std::vector<NodeId> const& component,
+        std::vector<NodeId> const& local_id, bool const with_in_arcs
+) {
+    auto const num_nodes = static_cast<NodeId>(nodes.size());
+    auto const index = component[nodes.front()];
+    ComponentGraph result{num_nodes, {}, {}, {}, {}};
+    result.out_offsets.reserve(num_nodes + 1);
+    result.out_offsets.push_back(0);
+    for (auto const node : nodes) {
+        for (auto const& arc : graph.out_arcs(node)) {
+            if (component[arc.neighbor] == index) {
+                result.out_arcs.push_back(LocalArc{local_id[arc.neighbor], arc.weight});
+            }
+        }
+        result.out_offsets.push_back(result.out_arcs.size());
+    }
+    if (with_in_arcs) {
+        result.in_offsets.assign(num_nodes + 1, 0);
+        for (auto const& arc : result.out_arcs) {
+            ++result.in_offsets[arc.node + 1];
+        }
+        std::partial_sum(result.in_offsets.begin(), result.in_offsets.end(), result.in_offsets.begin());
+        result.in_arcs.resize(result.out_arcs.size());
+        std::vector<size_t> next_free(result.in_offsets.begin(), result.in_offsets.end() - 1);
+        for (NodeId node = 0; node < num_nodes; ++node) {
+            for (auto const& arc : result.out(node)) {
+                result.in_arcs[next_free[arc.node]++] = LocalArc{node, arc.weight};
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Howard's policy iteration in the variant for strongly connected graphs: every node follows one of its arcs (the
+ * policy), the cheapest cycle of the policy is determined and all nodes are connected to it. Then every node switches
+ * to an arc on which it reaches the cycle more cheaply, until there is none.
+ */
+LocalCycle run_howard(ComponentGraph const& graph, size_t& num_iterations) {
+    auto const num_nodes = graph.num_nodes;
+    // The arc every node follows, initially its cheapest one
+    std::vector<NodeId> successor(num_nodes);
+    std::vector<EdgeWeight> successor_weight(num_nodes);
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        auto const arcs = graph.out(node);
+        auto const cheapest = std::min_element(arcs.begin(), arcs.end(), [](LocalArc const& a, LocalArc const& b) {
+            return a.weight < b.weight;
+        });
+        successor[node] = cheapest->node;
+        successor_weight[node] = cheapest->weight;
+    }
+    // visited[v] is start + 1 if v was first visited by the walk from start
+    std::vector<NodeId> visited(num_nodes);
+    std::vector<char> reached(num_nodes);
+    std::vector<NodeId> queue;
+    queue.reserve(num_nodes);
+    // The weight of a path to the best cycle, with arc weights reduced by its mean and scaled by its denominator
+    std::vector<Int128> distance(num_nodes);
+    while (true) {
+        ++num_iterations;
+        // Every node reaches exactly one cycle by following the policy. Walk from every node until reaching a node
+        // visited before, which closes a new cycle if it was visited by the same walk. Keep the cheapest cycle.
+        std::fill(visited.begin(), visited.end(), 0);
+        NodeId best_node = 0;
+        std::optional<Gamma> best_mean;
+        for (NodeId start = 0; start < num_nodes; ++start) {
+            auto node = start;
+            while (visited[node] == 0) {
+                visited[node] = start + 1;
+                node = successor[node];
+            }
+            if (visited[node] != start + 1) {
+                continue;
+            }
+            AccumulatedEdgeWeight cost = 0;
+            size_t length = 0;
+            auto current = node;
+            do {
+                cost += successor_weight[current];
+                ++length;
+                current = successor[current];
+            } while (current != node);
+            auto const mean = Gamma{cost, length}.reduced();
+            if (not best_mean or is_less(mean, *best_mean)) {
+                best_mean = mean;
+                best_node = node;
+            }
+        }
+
+        // Compute the distances to the best cycle: first backwards along the policy, then every other node is rerouted
+        // to the first reached node it has an arc to. All nodes are reached, the component is strongly connected.
+        std::fill(reached.begin(), reached.end(), false);
+        queue.clear();
+        reached[best_node] = true;
+        distance[best_node] = 0;
+        queue.push_back(best_node);
+        for (size_t front = 0; front < queue.size(); ++front) {
+            auto const node = queue[front];
+            for (auto const& arc : graph.in(node)) {
+                if (not reached[arc.node] and successor[arc.node] == node) {
+                    reached[arc.node] = true;
+                    distance[arc.node] = distance[node] + reduced_cost(arc.weight, *best_mean);
+                    queue.push_back(arc.node);
+                }
+            }
+        }
+        for (size_t front = 0; queue.size() < num_nodes; ++front) {
+            assert(front < queue.size());
+            auto const node = queue[front];
+            for (auto const& arc : graph.in(node)) {
+                if (not reached[arc.node]) {
+                    reached[arc.node] = true;
+                    successor[arc.node] = node;
+                    successor_weight[arc.node] = arc.weight;
+                    distance[arc.node] = distance[node] + reduced_cost(arc.weight, *best_mean);
+                    queue.push_back(arc.node);
+                }
+            }
+        }
+
+        // Follow every arc that leads to the best cycle more cheaply. If there is none, no cycle has a smaller mean.
+        bool improved = false;
+        for (NodeId node = 0; node < num_nodes; ++node) {
+            for (auto const& arc : graph.out(node)) {
+                auto const candidate = distance[arc.node] + reduced_cost(arc.weight, *best_mean);
+                if (candidate < distance[node]) {
+                    distance[node] = candidate;
+                    successor[node] = arc.node;
+                    successor_weight[node] = arc.weight;
+                    improved = true;
+                }
+            }
+        }
+        if (not improved) {
+            LocalCycle cycle{{}, *best_mean};
+            auto node = best_node;
+            do {
+                cycle.first.push_back(node);
+                node = successor[node];
+            } while (node != best_node);
+            return cycle;
+        }
+    }
+}
+
+/// Karp's algorithm, throws if its tables would not fit into max_karp_table_size entries
+LocalCycle run_karp(ComponentGraph const& graph) {
+    size_t const num_nodes = graph.num_nodes;
+    if ((num_nodes + 1) * num_nodes > max_karp_table_size) {
+        throw std::runtime_error("Karp's algorithm needs too much memory for a strongly connected component with "
+                                 + std::to_string(num_nodes) + " nodes.");
+    }
+    // Row k of walk_weight holds for every node the minimum weight of a walk with k arcs ending there, row k of
+    // predecessor the node before it on such a walk. Every row is finite, every node has an entering arc.
+    std::vector<AccumulatedEdgeWeight> walk_weight(
+            (num_nodes + 1) * num_nodes, std::numeric_limits<AccumulatedEdgeWeight>::max()
+    );
+    std::vector<NodeId> predecessor((num_nodes + 1) * num_nodes);
+    std::fill_n(walk_weight.begin(), num_nodes, 0);
+    for (size_t k = 1; k <= num_nodes; ++k) {
+        auto const* const previous = walk_weight.data() + (k - 1) * num_nodes;
+        auto* const current = walk_weight.data() + k * num_nodes;
+        for (NodeId node = 0; node < num_nodes; ++node) {
+            for (auto const& arc : graph.out(node)) {
+                if (previous[node] + arc.weight < current[arc.node]) {
+                    current[arc.node] = previous[node] + arc.weight;
+                    predecessor[k * num_nodes + arc.node] = node;
+                }
+            }
+        }
+    }
+
+    // The minimum mean is the minimum over all nodes v of the maximum over k < n of (W_n(v) - W_k(v)) / (n - k)
+    auto const weight = [&walk_weight, num_nodes](size_t const k, size_t const node) {
+        return walk_weight[k * num_nodes + node];
+    };
+    std::optional<Gamma> minimum_mean;
+    NodeId minimizer = 0;
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        Gamma maximum{weight(num_nodes, node) - weight(0, node), num_nodes};
+        for (size_t k = 1; k < num_nodes; ++k) {
+            Gamma const value{weight(num_nodes, node) - weight(k, node), num_nodes - k};
+            if (is_less(maximum, value)) {
+                maximum = value;
+            }
+        }
+        if (not minimum_mean or is_less(maximum, *minimum_mean)) {
+            minimum_mean = maximum;
+            minimizer = node;
+        }
+    }
+
+    // The minimum walk with n arcs to the minimizer splits into cycles and a path, and one of the cycles has the
+    // minimum mean. Split it with a stack of the nodes walked so far, closing a cycle whenever a node repeats.
+    std::vector<NodeId> walk(num_nodes + 1);
+    walk[num_nodes] = minimizer;
+    for (auto k = num_nodes; k > 0; --k) {
+        walk[k - 1] = predecessor[k * num_nodes + walk[k]];
+    }
+    auto const not_on_stack = std::numeric_limits<size_t>::max();
+    std::vector<size_t> stack_position(num_nodes, not_on_stack);
+    std::vector<NodeId> stack;
+    // The weight of the arc from stack[i] to stack[i + 1] (or to the current node for the last entry)
+    std::vector<AccumulatedEdgeWeight> stack_weights;
+    std::optional<LocalCycle> best;
+    for (size_t k = 0; k <= num_nodes; ++k) {
+        auto const node = walk[k];
+        auto const position = stack_position[node];
+        if (position == not_on_stack) {
+            stack_position[node] = stack.size();
+            stack.push_back(node);
+        } else {
+            auto const cost = std::accumulate(
+                    stack_weights.begin() + position, stack_weights.end(), AccumulatedEdgeWeight{0}
+            );
+            auto const mean = Gamma{cost, stack.size() - position}.reduced();
+            if (not best or is_less(mean, best->second)) {
+                best = LocalCycle{{stack.begin() + position, stack.end()}, mean};
+            }
+            for (auto i = position + 1; i < stack.size(); ++i) {
+                stack_position[stack[i]] = not_on_stack;
+            }
+            stack.resize(position + 1);
+            stack_weights.resize(position);
+        }
+        if (k < num_nodes) {
+            stack_weights.push_back(weight(k + 1, walk[k + 1]) - weight(k, node));
+        }
+    }
+    assert(best and not is_less(best->second, *minimum_mean) and not is_less(*minimum_mean, best->second));
+    return *best;
+}
+
+} // end of anonymous namespace
+
+DirectedMinimumMeanCycleCalculator::DirectedMinimumMeanCycleCalculator(
+        Digraph const& graph, DirectedMinimumMeanCycleOptions const options
+) : _graph(graph),
+    _options(options) {}
+
+std::optional<std::pair<std::vector<Edge>, Gamma>> DirectedMinimumMeanCycleCalculator::find_mmc() {
+    auto const components = find_cyclic_strong_components(_graph);
+    _num_components = components.size();
+    std::vector<NodeId> component(_graph.num_nodes(), no_component);
+    std::vector<NodeId> local_id(_graph.num_nodes(), 0);
+    for (NodeId index = 0; index < components.size(); ++index) {
+        for (NodeId i = 0; i < components[index].size(); ++i) {
+            component[components[index][i]] = index;
+            local_id[components[index][i]] = i;
+        }
+    }
+
+    // The largest components come first, so parallel_for_dynamic balances the load
+    bool const howard = _options.algorithm == DirectedAlgorithm::howard;
+    std::vector<LocalCycle> results(components.size());
+    std::vector<size_t> num_iterations(components.size(), 0);
+    parallel_for_dynamic(components.size(), resolve_num_threads(_options.num_threads), [&](size_t const i, unsigned) {
+        auto const component_graph = make_component_graph(_graph, components[i], component, local_id, howard);
+        results[i] = howard ? run_howard(component_graph, num_iterations[i]) : run_karp(component_graph);
+    });
+    _num_iterations = std::accumulate(num_iterations.begin(), num_iterations.end(), size_t{0});
+
+    size_t best = 0;
+    for (size_t i = 1; i < results.size(); ++i) {
+        if (is_less(results[i].second, results[best].second)) {
+            best = i;
+        }
+    }
+    if (results.empty()) {
+        return std::nullopt;
+    }
+    auto const& nodes = components[best];
+    auto const& cycle = results[best].first;
+    std::vector<Edge> arcs;
+    arcs.reserve(cycle.size());
+    for (size_t i = 0; i < cycle.size(); ++i) {
+        arcs.emplace_back(nodes[cycle[i]], nodes[cycle[(i + 1) % cycle.size()]]);
+    }
+    return std::make_pair(std::move(arcs), results[best].second);
+}
+
+}
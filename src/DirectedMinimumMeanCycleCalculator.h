@@ -0,0 +1,60 @@
+#ifndef MINIMUMMEANCYCLE_DIRECTEDMINIMUMMEANCYCLECALCULATOR_H
+#define MINIMUMMEANCYCLE_DIRECTEDMINIMUMMEANCYCLECALCULATOR_H
+
+#include <optional>
+#include <utility>
+#include <vector>
+#include "Digraph.h"
+#include "Gamma.h"
+
+namespace MMC {
+
+enum class DirectedAlgorithm {
+    /**
+     * Howard's policy iteration: every node follows one of its arcs, the cheapest cycle of these arcs is evaluated and
+     * the arcs are improved until no node can reach the cycle more cheaply. Every iteration takes O(m) time and the
+     * number of iterations is small in practice, although no polynomial bound is known.
+     */
+    howard,
+    /// Karp's algorithm: O(n m) time and O(n²) memory per strongly connected component, meant as a reference
+    karp,
+};
+
+struct DirectedMinimumMeanCycleOptions {
+    DirectedAlgorithm algorithm = DirectedAlgorithm::howard;
+    /// Number of threads solving strongly connected components concurrently, 0 uses all hardware threads
+    unsigned num_threads = 1;
+};
+
+/// Computes minimum mean cycles of digraphs, separately for every strongly connected component with a cycle
+class DirectedMinimumMeanCycleCalculator {
+public:
+    explicit DirectedMinimumMeanCycleCalculator(Digraph const& graph, DirectedMinimumMeanCycleOptions options = {});
+
+    /// A minimum mean cycle, as its arcs in the order of the cycle, or std::nullopt if the digraph is acyclic
+    std::optional<std::pair<std::vector<Edge>, Gamma>> find_mmc();
+
+    /// The number of strongly connected components with a cycle found by the last call to find_mmc
+    [[nodiscard]] size_t num_components() const;
+
+    /// The total number of policy iterations over all components in the last call to find_mmc, 0 for Karp's algorithm
+    [[nodiscard]] size_t num_iterations() const;
+
+private:
+    Digraph const& _graph;
+    DirectedMinimumMeanCycleOptions const _options;
+    size_t _num_components = 0;
+    size_t _num_iterations = 0;
+};
+
+inline size_t DirectedMinimumMeanCycleCalculator::num_components() const {
+    return _num_components;
+}
+
+inline size_t DirectedMinimumMeanCycleCalculator::num_iterations() const {
+    return _num_iterations;
+}
+
+}
+
+#endif //MINIMUMMEANCYCLE_DIRECTEDMINIMUMMEANCYCLECALCULATOR_H
@@ -1,6 +1,9 @@
 #ifndef MINIMUMMEANCYCLE_GAMMA_H
 #define MINIMUMMEANCYCLE_GAMMA_H
 
+#include <numeric>
+#include "graph.h"
+
 namespace MMC {
 
 /// Used to store the value of gamma without running into issues with floating point accuracy
@@ -16,11 +19,19 @@ struct Gamma {
 
     explicit operator double() const;
 
-    [[nodiscard]] AccumulatedEdgeWeight apply(EdgeWeight i) const;
+    /// The transformed cost of an edge: its weight minus gamma times its length, scaled by num_edges
+    [[nodiscard]] AccumulatedEdgeWeight apply(EdgeWeight i, EdgeLength length = 1) const;
+
+    /**
+     * The same value in lowest terms. This divides all transformed costs by the common divisor, so it keeps the path
+     * costs of the T-join computations as small as possible.
+     */
+    [[nodiscard]] Gamma reduced() const;
 };
 
 inline bool Gamma::operator==(Gamma const& other) const {
-    return cost_sum * other.num_edges == other.cost_sum * num_edges;
+    return cost_sum * static_cast<AccumulatedEdgeWeight>(other.num_edges)
+           == other.cost_sum * static_cast<AccumulatedEdgeWeight>(num_edges);
 }
 
 inline bool Gamma::operator!=(Gamma const& other) const {
@@ -31,13 +42,19 @@ inline Gamma::operator double() const {
     return static_cast<double>(cost_sum) / static_cast<double>(num_edges);
 }
 
-inline AccumulatedEdgeWeight Gamma::apply(EdgeWeight i) const {
-    return i * static_cast<AccumulatedEdgeWeight>(num_edges) - cost_sum;
+inline AccumulatedEdgeWeight Gamma::apply(EdgeWeight i, EdgeLength const length) const {
+    return i * static_cast<AccumulatedEdgeWeight>(num_edges) - cost_sum * static_cast<AccumulatedEdgeWeight>(length);
+}
+
+inline Gamma Gamma::reduced() const {
+    auto const divisor = std::gcd(cost_sum, static_cast<AccumulatedEdgeWeight>(num_edges));
+    return Gamma{cost_sum / divisor, num_edges / static_cast<size_t>(divisor)};
 }
 
 inline bool Gamma::operator<(Gamma const& other) const {
-    // Correct since num_edges is positive
-    return cost_sum * other.num_edges < other.cost_sum * num_edges;
+    // Correct since num_edges is positive. The products have to be signed, cost_sum may be negative.
+    return cost_sum * static_cast<AccumulatedEdgeWeight>(other.num_edges)
+           < other.cost_sum * static_cast<AccumulatedEdgeWeight>(num_edges);
 }
 
 }
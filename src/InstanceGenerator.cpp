@@ -0,0 +1,212 @@
+#include "InstanceGenerator.h" // always include corresponding header first
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace MMC {
+
+InstanceGenerator::InstanceGenerator(uint64_t const seed, EdgeWeight const max_absolute_weight)
+        : _random_generator(seed), _max_absolute_weight(max_absolute_weight) {
+    if (max_absolute_weight < 0) {
+        throw std::runtime_error("The maximum absolute weight must not be negative.");
+    }
+}
+
+uint64_t InstanceGenerator::random_below(uint64_t const bound) {
+    // Rejection sampling instead of std::uniform_int_distribution, whose results differ between standard libraries
+    auto const limit = std::numeric_limits<uint64_t>::max() - std::numeric_limits<uint64_t>::max() % bound;
+    while (true) {
+        auto const value = _random_generator();
+        if (value < limit) {
+            return value % bound;
+        }
+    }
+}
+
+EdgeWeight InstanceGenerator::random_weight() {
+    auto const range = 2 * static_cast<uint64_t>(_max_absolute_weight) + 1;
+    return static_cast<EdgeWeight>(static_cast<int64_t>(random_below(range)) - _max_absolute_weight);
+}
+
+Graph InstanceGenerator::make_graph(NodeId const num_nodes, std::vector<Edge> edges) {
+    std::vector<EdgeWeight> weights(edges.size());
+    for (auto& weight : weights) {
+        weight = random_weight();
+    }
+    return Graph(num_nodes, std::move(edges), weights);
+}
+
+Graph InstanceGenerator::complete(NodeId const num_nodes) {
+    std::vector<Edge> edges;
+    edges.reserve(static_cast<size_t>(num_nodes) * (num_nodes - 1) / 2);
+    for (NodeId lower = 0; lower < num_nodes; ++lower) {
+        for (NodeId higher = lower + 1; higher < num_nodes; ++higher) {
+            edges.emplace_back(lower, higher);
+        }
+    }
+    return make_graph(num_nodes, std::move(edges));
+}
+
+Graph InstanceGenerator::random_sparse(NodeId const num_nodes, EdgeIndex const num_edges) {
+    if (num_edges > static_cast<uint64_t>(num_nodes) * (num_nodes - 1) / 2) {
+        throw std::runtime_error("Too many edges for a simple graph on the given number of nodes.");
+    }
+    std::vector<Edge> edges;
+    edges.reserve(num_edges);
+    std::unordered_set<uint64_t> used;
+    used.reserve(num_edges);
+    while (edges.size() < num_edges) {
+        auto const first = static_cast<NodeId>(random_below(num_nodes));
+        auto const second = static_cast<NodeId>(random_below(num_nodes));
+        if (first == second) {
+            continue;
+        }
+        auto const lower = std::min(first, second);
+        auto const higher = std::max(first, second);
+        if (used.insert(static_cast<uint64_t>(lower) << 32 | higher).second) {
+            edges.emplace_back(lower, higher);
+        }
+    }
+    return make_graph(num_nodes, std::move(edges));
+}
+
+Graph InstanceGenerator::grid(NodeId const rows, NodeId const columns) {
+    std::vector<Edge> edges;
+    for (NodeId row = 0; row < rows; ++row) {
+        for (NodeId column = 0; column < columns; ++column) {
+            auto const node = row * columns + column;
+            if (column + 1 < columns) {
+                edges.emplace_back(node, node + 1);
+            }
+            if (row + 1 < rows) {
+                edges.emplace_back(node, node + columns);
+            }
+        }
+    }
+    return make_graph(rows * columns, std::move(edges));
+}
+
+Graph InstanceGenerator::planar(NodeId const rows, NodeId const columns) {
+    std::vector<Edge> edges;
+    for (NodeId row = 0; row < rows; ++row) {
+        for (NodeId column = 0; column < columns; ++column) {
+            auto const node = row * columns + column;
+            if (column + 1 < columns) {
+                edges.emplace_back(node, node + 1);
+            }
+            if (row + 1 < rows) {
+                edges.emplace_back(node, node + columns);
+            }
+            if (column + 1 < columns and row + 1 < rows) {
+                if (random_below(2) == 0) {
+                    edges.emplace_back(node, node + columns + 1);
+                } else {
+                    edges.emplace_back(node + 1, node + columns);
+                }
+            }
+        }
+    }
+    return make_graph(rows * columns, std::move(edges));
+}
+
+Graph InstanceGenerator::geometric(NodeId const num_nodes, double const average_degree) {
+    if (num_nodes == 0) {
+        return Graph(0, {}, {});
+    }
+    // Also rejects NaN, which would make the radius below undefined
+    if (not(average_degree > 0 and average_degree < static_cast<double>(num_nodes) - 1)) {
+        throw std::runtime_error("The average degree has to be positive and less than the number of nodes minus 1.");
+    }
+    // Coordinates are integers so that the result does not depend on floating point rounding
+    constexpr int64_t side = int64_t{1} << 30;
+    std::vector<std::pair<int64_t, int64_t>> points(num_nodes);
+    for (auto& point : points) {
+        point.first = static_cast<int64_t>(random_below(side));
+        point.second = static_cast<int64_t>(random_below(side));
+    }
+    auto const radius = static_cast<int64_t>(
+            std::sqrt(average_degree / (M_PI * num_nodes)) * static_cast<double>(side)
+    ) + 1;
+    auto const squared_radius = radius * radius;
+    // Bucket the points into square cells of side length radius, only neighbouring cells have to be compared
+    auto const cells_per_side = std::max<int64_t>(1, std::min<int64_t>(side / radius, 1 << 16));
+    auto const cell_size = side / cells_per_side + 1;
+    auto const cell_of = [&](NodeId const node) {
+        return std::make_pair(points[node].first / cell_size, points[node].second / cell_size);
+    };
+    std::vector<size_t> cell_offsets(static_cast<size_t>(cells_per_side * cells_per_side) + 1, 0);
+    auto const cell_index = [cells_per_side](int64_t const x, int64_t const y) {
+        return static_cast<size_t>(x * cells_per_side + y);
+    };
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        auto const[x, y] = cell_of(node);
+        ++cell_offsets[cell_index(x, y) + 1];
+    }
+    std::partial_sum(cell_offsets.begin(), cell_offsets.end(), cell_offsets.begin());
+    std::vector<NodeId> nodes_by_cell(num_nodes);
+    std::vector<size_t> next_free(cell_offsets.begin(), cell_offsets.end() - 1);
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        auto const[x, y] = cell_of(node);
+        nodes_by_cell[next_free[cell_index(x, y)]++] = node;
+    }
+
+    std::vector<Edge> edges;
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        auto const[x, y] = cell_of(node);
+        for (auto other_x = std::max<int64_t>(0, x - 1); other_x <= std::min(cells_per_side - 1, x + 1); ++other_x) {
+            for (auto other_y = std::max<int64_t>(0, y - 1); other_y <= std::min(cells_per_side - 1, y + 1);
+                 ++other_y) {
+                auto const cell = cell_index(other_x, other_y);
+                for (auto i = cell_offsets[cell]; i < cell_offsets[cell + 1]; ++i) {
+                    auto const other = nodes_by_cell[i];
+                    auto const dx = points[node].first - points[other].first;
+                    auto const dy = points[node].second - points[other].second;
+                    if (node < other and dx * dx + dy * dy <= squared_radius) {
+                        edges.emplace_back(node, other);
+                    }
+                }
+            }
+        }
+    }
+    return make_graph(num_nodes, std::move(edges));
+}
+
+Graph InstanceGenerator::newton_adversarial(unsigned const num_cycles) {
+    if (num_cycles == 0 or num_cycles > 12) {
+        throw std::runtime_error("The number of cycles has to be between 1 and 12.");
+    }
+    // Cycle i (1-based) consists of the heavy edge and a path with num_edges_i - 1 edges, where
+    // num_edges_i = 2 * 4^(num_cycles - i) + 2, and has mean -i. In a Newton step at gamma = -j, cycle i has reduced
+    // cost num_edges_i * (j - i), which is minimized by i = j + 1 since num_edges_(j+1) > (i - j) * num_edges_i for
+    // all i > j + 1.
+    // The paths get a large positive weight (and the heavy edge the same negative weight), so cycles avoiding the heavy
+    // edge have positive mean and never appear in a minimum join.
+    auto const cycle_length = [num_cycles](unsigned const i) {
+        return 2 * (AccumulatedEdgeWeight{1} << (2 * (num_cycles - i))) + 2;
+    };
+    AccumulatedEdgeWeight const heavy_weight = num_cycles * cycle_length(1) + 1;
+    NodeId const first_hub = 0;
+    NodeId const second_hub = 1;
+    NodeId num_nodes = 2;
+    std::vector<Edge> edges{{first_hub, second_hub}};
+    std::vector<EdgeWeight> weights{static_cast<EdgeWeight>(-heavy_weight)};
+    for (unsigned i = 1; i <= num_cycles; ++i) {
+        auto const length = cycle_length(i);
+        auto const path_edges = length - 1;
+        auto const path_weight = heavy_weight - static_cast<AccumulatedEdgeWeight>(i) * length;
+        auto previous = first_hub;
+        for (AccumulatedEdgeWeight edge = 0; edge < path_edges; ++edge) {
+            auto const next = edge + 1 == path_edges ? second_hub : num_nodes++;
+            edges.emplace_back(previous, next);
+            // Distribute the path weight as evenly as possible
+            weights.push_back(static_cast<EdgeWeight>(
+                    path_weight / path_edges + (edge < path_weight % path_edges ? 1 : 0)
+            ));
+            previous = next;
+        }
+    }
+    return Graph(num_nodes, std::move(edges), weights);
+}
+
+}
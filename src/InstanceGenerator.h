@@ -0,0 +1,63 @@
+#ifndef MINIMUMMEANCYCLE_INSTANCEGENERATOR_H
+#define MINIMUMMEANCYCLE_INSTANCEGENERATOR_H
+
+#include <cstdint>
+#include <random>
+#include "graph.h"
+
+namespace MMC {
+
+/**
+ * Generates random weighted graphs of several families. Edge weights are drawn uniformly from
+ * [-max_absolute_weight, max_absolute_weight]. The generated graphs only depend on the seed and the calls made, not on
+ * the platform or standard library, so instances can be reproduced from their parameters.
+ */
+class InstanceGenerator {
+public:
+    InstanceGenerator(uint64_t seed, EdgeWeight max_absolute_weight);
+
+    /// The complete graph on num_nodes nodes
+    Graph complete(NodeId num_nodes);
+
+    /// A graph chosen uniformly among all graphs with num_nodes nodes and num_edges edges (Erdős–Rényi G(n, m))
+    Graph random_sparse(NodeId num_nodes, EdgeIndex num_edges);
+
+    /// The rows x columns grid graph
+    Graph grid(NodeId rows, NodeId columns);
+
+    /// A planar triangulation: the rows x columns grid with one randomly chosen diagonal in every cell
+    Graph planar(NodeId rows, NodeId columns);
+
+    /**
+     * A random geometric graph: num_nodes points placed uniformly in the unit square, two points are adjacent if their
+     * distance is at most a radius chosen such that the expected degree is average_degree (ignoring the boundary).
+     * Throws if average_degree is not in the open interval (0, num_nodes - 1).
+     */
+    Graph geometric(NodeId num_nodes, double average_degree);
+
+    /**
+     * An instance on which Newton's method for the minimum mean needs one T-join computation per cycle. The graph
+     * consists of num_cycles + 1 internally disjoint paths between two nodes: one heavy edge and num_cycles paths whose
+     * lengths decrease geometrically (by a factor of four). Every cycle through the heavy edge has a slightly lower
+     * mean than the previous one, but the shorter length makes it less attractive to the T-join, so every Newton step
+     * only advances to the next cycle. The weights are deterministic, max_absolute_weight and the seed are ignored.
+     * The number of edges grows like 4^num_cycles.
+     */
+    static Graph newton_adversarial(unsigned num_cycles);
+
+private:
+    /// Uniformly distributed in [0, bound)
+    uint64_t random_below(uint64_t bound);
+
+    EdgeWeight random_weight();
+
+    /// Draws a weight for every edge and creates the graph
+    Graph make_graph(NodeId num_nodes, std::vector<Edge> edges);
+
+    std::mt19937_64 _random_generator;
+    EdgeWeight const _max_absolute_weight;
+};
+
+}
+
+#endif //MINIMUMMEANCYCLE_INSTANCEGENERATOR_H
@@ -0,0 +1,122 @@
+#include "Instrumentation.h" // always include corresponding header first
+#include <ostream>
+
+namespace MMC {
+
+char const* to_string(Phase const phase) {
+    switch (phase) {
+        case Phase::negative_edge_scan:
+            return "negative_edge_scan";
+        case Phase::dijkstra:
+            return "dijkstra";
+        case Phase::matching_setup:
+            return "matching_setup";
+        case Phase::matching_solve:
+            return "matching_solve";
+        case Phase::join_extraction:
+            return "join_extraction";
+        case Phase::cycle_heuristic:
+            return "cycle_heuristic";
+    }
+    return "unknown";
+}
+
+char const* to_string(Counter const counter) {
+    switch (counter) {
+        case Counter::odd_nodes:
+            return "odd_nodes";
+        case Counter::heap_pushes:
+            return "heap_pushes";
+        case Counter::stale_heap_pops:
+            return "stale_heap_pops";
+        case Counter::matching_edges:
+            return "matching_edges";
+        case Counter::pruned_pairs:
+            return "pruned_pairs";
+    }
+    return "unknown";
+}
+
+Profile& Profile::operator+=(Profile const& other) {
+    for (size_t i = 0; i < num_phases; ++i) {
+        seconds[i] += other.seconds[i];
+    }
+    for (size_t i = 0; i < num_counters; ++i) {
+        counters[i] += other.counters[i];
+    }
+    return *this;
+}
+
+void Profile::write_json(std::ostream& output) const {
+    output << "{\"phases\": {";
+    for (size_t i = 0; i < num_phases; ++i) {
+        output << (i == 0 ? "" : ", ") << '"' << to_string(static_cast<Phase>(i)) << "\": " << seconds[i];
+    }
+    output << "}, \"counters\": {";
+    for (size_t i = 0; i < num_counters; ++i) {
+        output << (i == 0 ? "" : ", ") << '"' << to_string(static_cast<Counter>(i)) << "\": " << counters[i];
+    }
+    output << "}}";
+}
+
+#ifdef MMC_INSTRUMENTATION
+
+thread_local ProfileRecorder* ProfileRecorder::_current = nullptr;
+
+void ProfileRecorder::add_seconds(Phase const phase, double const seconds) {
+    _nanoseconds[static_cast<size_t>(phase)].fetch_add(static_cast<uint64_t>(seconds * 1e9), std::memory_order_relaxed);
+}
+
+void ProfileRecorder::add_count(Counter const counter, uint64_t const amount) {
+    _counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+Profile ProfileRecorder::snapshot() const {
+    Profile result;
+    for (size_t i = 0; i < num_phases; ++i) {
+        result.seconds[i] = static_cast<double>(_nanoseconds[i].load(std::memory_order_relaxed)) * 1e-9;
+    }
+    for (size_t i = 0; i < num_counters; ++i) {
+        result.counters[i] = _counters[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+ProfileRecorder* ProfileRecorder::current() {
+    return _current;
+}
+
+void ProfileRecorder::count(Counter const counter, uint64_t const amount) {
+    if (_current) {
+        _current->add_count(counter, amount);
+    }
+}
+
+ScopedProfileRecorder::ScopedProfileRecorder(ProfileRecorder* const recorder) : _previous(ProfileRecorder::_current) {
+    ProfileRecorder::_current = recorder;
+}
+
+ScopedProfileRecorder::~ScopedProfileRecorder() {
+    ProfileRecorder::_current = _previous;
+}
+
+PhaseTimer::PhaseTimer(Phase const phase) : _phase(phase), _start(std::chrono::steady_clock::now()) {}
+
+PhaseTimer::~PhaseTimer() {
+    stop();
+}
+
+void PhaseTimer::stop() {
+    if (not _running) {
+        return;
+    }
+    _running = false;
+    if (auto* const recorder = ProfileRecorder::current()) {
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - _start;
+        recorder->add_seconds(_phase, elapsed.count());
+    }
+}
+
+#endif
+
+}
@@ -0,0 +1,182 @@
+#ifndef MINIMUMMEANCYCLE_INSTRUMENTATION_H
+#define MINIMUMMEANCYCLE_INSTRUMENTATION_H
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+
+/**
+ * @file Instrumentation.h
+ *
+ * Per-phase timings and event counters of the minimum mean cycle computation. Recording is only compiled in if
+ * MMC_INSTRUMENTATION is defined (CMake option MMC_INSTRUMENTATION). Otherwise the MMC_INSTRUMENT_* macros expand to
+ * nothing and every Profile stays zero.
+ *
+ * Measurements are recorded into the ProfileRecorder installed for the current thread with MMC_INSTRUMENT_RECORD_TO.
+ * parallel_for_dynamic passes the recorder on to its worker threads.
+ */
+
+namespace MMC {
+
+enum class Phase {
+    /// Finding the edges with negative transformed cost and the resulting odd nodes
+    negative_edge_scan,
+    /// Shortest path computations between odd nodes, including Voronoi regions and pricing
+    dijkstra,
+    /// Creating the matching instance or updating its edge costs
+    matching_setup,
+    /// PerfectMatching::Solve
+    matching_solve,
+    /// Turning the matching into a join: reading the solution, rebuilding paths, symmetric difference
+    join_extraction,
+    /// Splitting joins into circuits and searching for good cycles
+    cycle_heuristic,
+};
+
+constexpr size_t num_phases = 6;
+
+enum class Counter {
+    /// Number of odd nodes, summed over all T-join computations
+    odd_nodes,
+    heap_pushes,
+    /// Heap entries popped after their node had already been fixed
+    stale_heap_pops,
+    /// Edges of the matching instances, including edges added by pricing
+    matching_edges,
+    /// Pairs of odd nodes left out of the all-pairs matching by pruning (or because they are not connected)
+    pruned_pairs,
+};
+
+constexpr size_t num_counters = 5;
+
+/// Is recording compiled in?
+#ifdef MMC_INSTRUMENTATION
+constexpr bool instrumentation_enabled = true;
+#else
+constexpr bool instrumentation_enabled = false;
+#endif
+
+char const* to_string(Phase phase);
+
+char const* to_string(Counter counter);
+
+/// Accumulated measurements. Phase times are wall clock times of the thread that started the phase.
+struct Profile {
+    std::array<double, num_phases> seconds{};
+    std::array<uint64_t, num_counters> counters{};
+
+    [[nodiscard]] double phase_seconds(Phase phase) const;
+
+    [[nodiscard]] uint64_t count(Counter counter) const;
+
+    Profile& operator+=(Profile const& other);
+
+    /// Writes the profile as a JSON object with members "phases" and "counters"
+    void write_json(std::ostream& output) const;
+};
+
+inline double Profile::phase_seconds(Phase const phase) const {
+    return seconds[static_cast<size_t>(phase)];
+}
+
+inline uint64_t Profile::count(Counter const counter) const {
+    return counters[static_cast<size_t>(counter)];
+}
+
+}
+
+#ifdef MMC_INSTRUMENTATION
+
+#include <atomic>
+#include <chrono>
+
+namespace MMC {
+
+/// Collects measurements, possibly from several threads at once
+class ProfileRecorder {
+public:
+    void add_seconds(Phase phase, double seconds);
+
+    void add_count(Counter counter, uint64_t amount);
+
+    [[nodiscard]] Profile snapshot() const;
+
+    /// The recorder of the calling thread, nullptr if none is installed
+    static ProfileRecorder* current();
+
+    /// Adds to the recorder of the calling thread, if any
+    static void count(Counter counter, uint64_t amount);
+
+private:
+    friend class ScopedProfileRecorder;
+
+    static thread_local ProfileRecorder* _current;
+
+    std::array<std::atomic<uint64_t>, num_phases> _nanoseconds{};
+    std::array<std::atomic<uint64_t>, num_counters> _counters{};
+};
+
+/// Installs a recorder for the calling thread for the lifetime of this object
+class ScopedProfileRecorder {
+public:
+    explicit ScopedProfileRecorder(ProfileRecorder* recorder);
+
+    ~ScopedProfileRecorder();
+
+    ScopedProfileRecorder(ScopedProfileRecorder const&) = delete;
+
+    ScopedProfileRecorder& operator=(ScopedProfileRecorder const&) = delete;
+
+private:
+    ProfileRecorder* const _previous;
+};
+
+/// Adds the time until stop() or its destruction to a phase of the recorder of the calling thread
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase phase);
+
+    ~PhaseTimer();
+
+    PhaseTimer(PhaseTimer const&) = delete;
+
+    PhaseTimer& operator=(PhaseTimer const&) = delete;
+
+    /// Records the elapsed time, later calls and the destructor do nothing
+    void stop();
+
+private:
+    Phase const _phase;
+    std::chrono::steady_clock::time_point const _start;
+    bool _running = true;
+};
+
+}
+
+#define MMC_INSTRUMENT_CONCAT_IMPL(a, b) a##b
+#define MMC_INSTRUMENT_CONCAT(a, b) MMC_INSTRUMENT_CONCAT_IMPL(a, b)
+/// Times the rest of the enclosing scope as the given phase
+#define MMC_INSTRUMENT_PHASE(phase) \
+    ::MMC::PhaseTimer const MMC_INSTRUMENT_CONCAT(mmc_phase_timer_, __LINE__){::MMC::Phase::phase}
+/// Times the given phase until MMC_INSTRUMENT_STOP(timer) or the end of the enclosing scope
+#define MMC_INSTRUMENT_START(timer, phase) ::MMC::PhaseTimer timer{::MMC::Phase::phase}
+#define MMC_INSTRUMENT_STOP(timer) timer.stop()
+#define MMC_INSTRUMENT_COUNT(counter, amount) ::MMC::ProfileRecorder::count(::MMC::Counter::counter, amount)
+/// Records into the given recorder (a pointer, may be nullptr) for the rest of the enclosing scope
+#define MMC_INSTRUMENT_RECORD_TO(recorder) \
+    ::MMC::ScopedProfileRecorder const MMC_INSTRUMENT_CONCAT(mmc_scoped_recorder_, __LINE__){recorder}
+/// The code is only compiled if instrumentation is enabled
+#define MMC_INSTRUMENT_ONLY(...) __VA_ARGS__
+
+#else
+
+#define MMC_INSTRUMENT_PHASE(phase) static_cast<void>(0)
+#define MMC_INSTRUMENT_START(timer, phase) static_cast<void>(0)
+#define MMC_INSTRUMENT_STOP(timer) static_cast<void>(0)
+#define MMC_INSTRUMENT_COUNT(counter, amount) static_cast<void>(0)
+#define MMC_INSTRUMENT_RECORD_TO(recorder) static_cast<void>(0)
+#define MMC_INSTRUMENT_ONLY(...)
+
+#endif
+
+#endif //MINIMUMMEANCYCLE_INSTRUMENTATION_H
@@ -0,0 +1,43 @@
+#include "MappedFile.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MMC {
+
+MappedFile::MappedFile(std::string const& path) {
+    int const file_descriptor = open(path.c_str(), O_RDONLY);
+    if (file_descriptor < 0) {
+        throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+    }
+    struct stat file_status{};
+    if (fstat(file_descriptor, &file_status) != 0) {
+        close(file_descriptor);
+        throw std::runtime_error("Failed to determine the size of " + path + ": " + std::strerror(errno));
+    }
+    _size = static_cast<size_t>(file_status.st_size);
+    if (_size > 0) {
+        _data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        if (_data == MAP_FAILED) {
+            _data = nullptr;
+            close(file_descriptor);
+            throw std::runtime_error("Failed to map " + path + ": " + std::strerror(errno));
+        }
+        // The file is usually read front to back, so aggressive read-ahead pays off
+        madvise(_data, _size, MADV_SEQUENTIAL);
+    }
+    // The mapping stays valid after closing the descriptor
+    close(file_descriptor);
+}
+
+MappedFile::~MappedFile() {
+    if (_data) {
+        munmap(_data, _size);
+    }
+}
+
+}
@@ -0,0 +1,42 @@
+#ifndef MINIMUMMEANCYCLE_MAPPEDFILE_H
+#define MINIMUMMEANCYCLE_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace MMC {
+
+/**
+ * A file mapped read-only into memory. The pages are only read from disk when they are accessed, so opening even very
+ * large files is cheap. Throws std::runtime_error if the file cannot be opened or mapped.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(std::string const& path);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    [[nodiscard]] char const* data() const;
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    void* _data = nullptr;
+    size_t _size = 0;
+};
+
+inline char const* MappedFile::data() const {
+    return static_cast<char const*>(_data);
+}
+
+inline size_t MappedFile::size() const {
+    return _size;
+}
+
+}
+
+#endif //MINIMUMMEANCYCLE_MAPPEDFILE_H
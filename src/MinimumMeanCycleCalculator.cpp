@@ -1,116 +1,556 @@
-#include <iostream>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
-#include <set>
-#include <map>
+#include <limits>
 #include <numeric>
 #include "MinimumMeanCycleCalculator.h"
+#include "Decomposition.h"
+#include "Parallel.h"
 #include "TJoinCalculator.h"
 
 namespace MMC {
 
-MinimumMeanCycleCalculator::MinimumMeanCycleCalculator(Graph const& graph) : _graph(graph) {}
+namespace {
+
+__extension__ using Int128 = __int128;
+
+struct Fraction {
+    Int128 numerator;
+    /// Always positive
+    Int128 denominator;
+};
+
+Int128 floor_div(Int128 const numerator, Int128 const denominator) {
+    assert(denominator > 0);
+    auto const quotient = numerator / denominator;
+    return quotient * denominator > numerator ? quotient - 1 : quotient;
+}
+
+/// Returns the fraction with the smallest denominator in the closed interval [lower, upper]
+Fraction simplest_fraction_between(Fraction const& lower, Fraction const& upper) {
+    auto const integer_part = floor_div(lower.numerator, lower.denominator);
+    if (integer_part * lower.denominator == lower.numerator) {
+        return Fraction{integer_part, 1};
+    }
+    if ((integer_part + 1) * upper.denominator <= upper.numerator) {
+        return Fraction{integer_part + 1, 1};
+    }
+    // Both bounds are in (integer_part, integer_part + 1). Recurse on the reciprocals of the fractional parts, which
+    // reverses their order.
+    auto const inner = simplest_fraction_between(
+            Fraction{upper.denominator, upper.numerator - integer_part * upper.denominator},
+            Fraction{lower.denominator, lower.numerator - integer_part * lower.denominator}
+    );
+    return Fraction{integer_part * inner.numerator + inner.denominator, inner.numerator};
+}
+
+Gamma to_gamma(Fraction const& fraction) {
+    return Gamma{static_cast<AccumulatedEdgeWeight>(fraction.numerator), static_cast<size_t>(fraction.denominator)};
+}
+
+Fraction to_fraction(Gamma const& gamma) {
+    return Fraction{gamma.cost_sum, static_cast<Int128>(gamma.num_edges)};
+}
+
+bool fits_gamma(Fraction const& fraction) {
+    return fraction.numerator >= std::numeric_limits<AccumulatedEdgeWeight>::min()
+           and fraction.numerator <= std::numeric_limits<AccumulatedEdgeWeight>::max()
+           and fraction.denominator <= std::numeric_limits<AccumulatedEdgeWeight>::max();
+}
+
+} // end of anonymous namespace
+
+MinimumMeanCycleCalculator::MinimumMeanCycleCalculator(
+        Graph const& graph, MinimumMeanCycleOptions const options, TJoinWorkspace* const workspace
+) : _graph(graph), _options(options), _workspace(workspace) {}
 
 std::optional<std::pair<std::vector<Edge>, Gamma>> MinimumMeanCycleCalculator::find_mmc() {
-    std::vector<Edge> result_cycle;
-    {
+    return find_mmc(SearchSeed{});
+}
+
+std::optional<std::pair<std::vector<Edge>, Gamma>> MinimumMeanCycleCalculator::find_mmc(SearchSeed const& seed) {
+    if (seed.cycle.empty()) {
+        return find_mmc_below(std::nullopt, seed.lower_bound);
+    }
+    auto const seed_mean = get_average_cost(seed.cycle);
+    auto result = find_mmc_below(seed_mean, seed.lower_bound);
+    if (not result) {
+        // Nothing is cheaper, so the seed cycle is optimal (or within the tolerance)
+        result.emplace(seed.cycle, seed_mean);
+    }
+    return result;
+}
+
+std::optional<std::pair<std::vector<Edge>, Gamma>> MinimumMeanCycleCalculator::find_mmc_below(
+        std::optional<Gamma> const upper_limit, std::optional<Gamma> const lower_bound
+) {
+    _iterations.clear();
+    _profile = Profile{};
+    _matching_statistics = MatchingStatistics{};
+    _lower_bound = Gamma{0, 1};
+    if (_options.decompose) {
+        auto const blocks = find_cyclic_blocks(_graph);
+        if (blocks.empty()) {
+            return std::nullopt;
+        }
+        if (blocks.size() > 1 or blocks.front().size() < _graph.num_edges()) {
+            return find_mmc_of_blocks(blocks, upper_limit, lower_bound);
+        }
+    }
+    if (_options.reduce) {
+        if (auto const reduced = reduce_graph(_graph)) {
+            return find_mmc_of_reduction(*reduced, upper_limit, lower_bound);
+        }
+    }
+    SearchState state;
+    if (upper_limit) {
+        // Only cheaper cycles are of interest, so the search starts at the limit as if it was the mean of a cycle
+        state.upper_bound = *upper_limit;
+    } else {
+        MMC_INSTRUMENT_ONLY(ProfileRecorder recorder;)
+        MMC_INSTRUMENT_RECORD_TO(&recorder);
+        MMC_INSTRUMENT_START(heuristic_timer, cycle_heuristic);
         // The only condition the proof places on the initial gamma is that it is an upper bound for the mean cost of an
         // MMC. So the mean weight of an arbitrary cycle (in this case chosen with heuristically high mean weight) is a
         // valid choice.
         std::vector<Edge> all_edges;
-        for (size_t lower = 0; lower < _graph.num_nodes(); ++lower) {
-            for (size_t higher = lower + 1; higher < _graph.num_nodes(); ++higher) {
-                Edge const edge{lower, higher};
-                if (_graph.edge_exists(edge)) {
-                    all_edges.push_back(edge);
-                }
-            }
+        all_edges.reserve(_graph.num_edges());
+        for (EdgeIndex i = 0; i < _graph.num_edges(); ++i) {
+            all_edges.push_back(_graph.edge(i));
         }
         auto const start_cycle = find_heuristically_good_circuit(all_edges);
+        MMC_INSTRUMENT_STOP(heuristic_timer);
         if (not start_cycle) {
             return std::nullopt;
         }
-        result_cycle = *start_cycle;
-    }
-    auto gamma = get_average_cost(result_cycle);
-
-    auto gamma_last = gamma;
-    do {
-        TJoinCalculator calc(_graph);
-        std::cout << "Calculating join with gamma=" << static_cast<double>(gamma) << '\n';
-        auto const& min_join = calc.get_minimum_zero_join(gamma);
-        if (not min_join.empty()) {
-            auto const gamma_next = get_average_cost(min_join);
-            gamma_last = gamma;
-            gamma = gamma_next;
-            result_cycle = find_heuristically_good_circuit(min_join).value();
-            auto const cycle_gamma = get_average_cost(result_cycle);
-            if (cycle_gamma < gamma) {
-                std::cout << "Using cost of cycle instead of join for larger step size\n";
-                gamma = cycle_gamma;
+        state.best_cycle = *start_cycle;
+        MMC_INSTRUMENT_ONLY(_profile = recorder.snapshot();)
+        state.upper_bound = get_average_cost(state.best_cycle);
+    }
+    // No cycle can be cheaper on average than the edge with the least weight per length
+    state.lower_bound = Gamma{std::numeric_limits<EdgeWeight>::max(), 1};
+    for (EdgeIndex i = 0; i < _graph.num_edges(); ++i) {
+        state.lower_bound = std::min(state.lower_bound, Gamma{_graph.edge_weight(i), _graph.edge_length(i)});
+    }
+    if (lower_bound) {
+        state.lower_bound = std::max(state.lower_bound, *lower_bound);
+    }
+    // A cycle through an edge of length l also passes the l - 1 nodes the edge stands for
+    state.max_cycle_length = _graph.num_nodes();
+    for (auto const length : _graph.edge_lengths()) {
+        state.max_cycle_length += length - 1;
+    }
+
+    // Only gamma changes between iterations, so the calculator is kept to allow warm starts of the matching
+    TJoinCalculator calc(_graph, _options.t_join, _workspace);
+    switch (_options.search_strategy) {
+        case GammaSearchStrategy::stern_brocot:
+            run_stern_brocot(calc, state);
+            break;
+        case GammaSearchStrategy::hybrid:
+            run_hybrid(calc, state);
+            break;
+        case GammaSearchStrategy::newton:
+        default:
+            run_newton(calc, state);
+            break;
+    }
+    _matching_statistics = calc.matching_statistics();
+    _lower_bound = state.lower_bound;
+    if (state.best_cycle.empty()) {
+        return std::nullopt;
+    }
+    return std::make_pair(state.best_cycle, state.upper_bound);
+}
+
+std::optional<std::pair<std::vector<Edge>, Gamma>> MinimumMeanCycleCalculator::find_mmc_of_blocks(
+        std::vector<std::vector<EdgeIndex>> const& blocks, std::optional<Gamma> const upper_limit,
+        std::optional<Gamma> const lower_bound
+) {
+    struct BlockResult {
+        std::optional<std::pair<std::vector<Edge>, Gamma>> cycle;
+        Gamma lower_bound;
+        MatchingStatistics matching_statistics;
+        std::vector<IterationStatistics> iterations;
+        Profile profile;
+    };
+    auto const num_threads = resolve_num_threads(_options.t_join.num_threads);
+    std::vector<BlockResult> results(blocks.size());
+    std::vector<TJoinWorkspace> own_workspaces(num_threads - (_workspace ? 1 : 0));
+    auto const workspace = [&](unsigned const thread_index) {
+        if (not _workspace) {
+            return &own_workspaces[thread_index];
+        }
+        return thread_index == 0 ? _workspace : &own_workspaces[thread_index - 1];
+    };
+    auto const solve_block = [&](size_t const block, unsigned const block_threads, TJoinWorkspace* const workspace) {
+        auto const subgraph = make_subgraph(_graph, blocks[block]);
+        auto options = _options;
+        options.decompose = false;
+        options.t_join.num_threads = block_threads;
+        MinimumMeanCycleCalculator calculator(subgraph.graph, options, workspace);
+        auto& result = results[block];
+        result.cycle = calculator.find_mmc_below(upper_limit, lower_bound);
+        if (result.cycle) {
+            for (auto& [first, second] : result.cycle->first) {
+                first = subgraph.original_nodes[first];
+                second = subgraph.original_nodes[second];
+            }
+        }
+        result.lower_bound = calculator.lower_bound();
+        result.matching_statistics = calculator.matching_statistics();
+        result.iterations = calculator.iterations();
+        result.profile = calculator.profile();
+    };
+    // The blocks are sorted by decreasing size. Large blocks are solved one after another with parallel shortest path
+    // computations, the others concurrently with one thread each.
+    size_t num_large_blocks = 0;
+    while (num_large_blocks < blocks.size() and num_threads > 1
+           and blocks[num_large_blocks].size() * num_threads >= _graph.num_edges()) {
+        solve_block(num_large_blocks, num_threads, workspace(0));
+        ++num_large_blocks;
+    }
+    parallel_for_dynamic(blocks.size() - num_large_blocks, num_threads, [&](size_t const item, unsigned const thread) {
+        solve_block(num_large_blocks + item, 1, workspace(thread));
+    });
+
+    // Every cycle is in one of the blocks, so the least of their lower bounds is one for the whole graph
+    std::optional<std::pair<std::vector<Edge>, Gamma>> best;
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto& result = results[i];
+        if (i == 0 or result.lower_bound < _lower_bound) {
+            _lower_bound = result.lower_bound;
+        }
+        if (result.cycle and (not best or result.cycle->second < best->second)) {
+            best = std::move(result.cycle);
+        }
+        _matching_statistics += result.matching_statistics;
+        std::move(result.iterations.begin(), result.iterations.end(), std::back_inserter(_iterations));
+        _profile += result.profile;
+    }
+    return best;
+}
+
+std::optional<std::pair<std::vector<Edge>, Gamma>> MinimumMeanCycleCalculator::find_mmc_of_reduction(
+        ReducedGraph const& reduced, std::optional<Gamma> const upper_limit, std::optional<Gamma> const lower_bound
+) {
+    // find_mmc decomposes before it reduces, and a second reduction would not change anything
+    auto options = _options;
+    options.decompose = false;
+    options.reduce = false;
+    MinimumMeanCycleCalculator calculator(reduced.graph, options, _workspace);
+    auto result = calculator.find_mmc_below(upper_limit, lower_bound);
+    if (result) {
+        result->first = reduced.expand(result->first);
+    }
+    _lower_bound = calculator.lower_bound();
+    _matching_statistics = calculator.matching_statistics();
+    _iterations = calculator.iterations();
+    _profile = calculator.profile();
+    return result;
+}
+
+bool MinimumMeanCycleCalculator::has_cycle_below(Gamma const gamma, TJoinCalculator& calc, SearchState& state) {
+    auto const start_time = std::chrono::steady_clock::now();
+    MMC_INSTRUMENT_ONLY(ProfileRecorder recorder;)
+    MMC_INSTRUMENT_RECORD_TO(&recorder);
+    auto const min_join = calc.get_minimum_zero_join(gamma);
+    AccumulatedEdgeWeight join_cost = 0;
+    for (auto const& edge : min_join) {
+        auto const[weight, length] = weight_and_length(edge);
+        join_cost += gamma.apply(weight, length);
+    }
+    bool const found_cheaper_cycle = join_cost < 0;
+    if (found_cheaper_cycle) {
+        MMC_INSTRUMENT_PHASE(cycle_heuristic);
+        // The join is a disjoint union of circuits. Its average cost is less than gamma, so the same holds for the best
+        // of these circuits.
+        for (auto& circuit : split_into_circuits(min_join)) {
+            auto const circuit_gamma = get_average_cost(circuit);
+            if (circuit_gamma < state.upper_bound) {
+                state.upper_bound = circuit_gamma;
+                state.best_cycle = std::move(circuit);
+            }
+        }
+        assert(state.upper_bound < gamma);
+        // Every cycle C is an \emptyset-join, so k w(C) - S l(C) >= join_cost for gamma = S / k, where w(C) is the
+        // weight and l(C) >= 3 the length of C. Hence the minimum mean is at least S / k + join_cost / (3 k).
+        auto const numerator = 3 * static_cast<Int128>(gamma.cost_sum) + join_cost;
+        auto const denominator = 3 * static_cast<Int128>(gamma.num_edges);
+        if (fits_gamma(Fraction{numerator, denominator})) {
+            state.lower_bound = std::max(state.lower_bound, to_gamma(Fraction{numerator, denominator}).reduced());
+        }
+    } else if (state.lower_bound < gamma) {
+        state.lower_bound = gamma;
+    }
+    std::chrono::duration<double> const time = std::chrono::steady_clock::now() - start_time;
+    _iterations.push_back(IterationStatistics{gamma, time.count(), found_cheaper_cycle, {}});
+    MMC_INSTRUMENT_ONLY(_iterations.back().profile = recorder.snapshot();)
+    _profile += _iterations.back().profile;
+    return found_cheaper_cycle;
+}
+
+bool MinimumMeanCycleCalculator::is_minimum_below(Gamma const gamma, TJoinCalculator& calc, SearchState& state) {
+    if (state.upper_bound < gamma) {
+        return true;
+    }
+    if (not(state.lower_bound < gamma)) {
+        return false;
+    }
+    return has_cycle_below(gamma, calc, state);
+}
+
+bool MinimumMeanCycleCalculator::is_within_tolerance(SearchState const& state) const {
+    if (not(state.lower_bound < state.upper_bound)) {
+        return true;
+    }
+    if (_options.epsilon <= 0) {
+        return false;
+    }
+    auto const lower = static_cast<double>(state.lower_bound);
+    auto const upper = static_cast<double>(state.upper_bound);
+    return upper - lower <= _options.epsilon * std::max(std::abs(lower), std::abs(upper));
+}
+
+void MinimumMeanCycleCalculator::run_newton(TJoinCalculator& calc, SearchState& state) {
+    // Every iteration either proves that the best known cycle is optimal or strictly improves it
+    while (not is_within_tolerance(state) and is_minimum_below(state.upper_bound, calc, state)) {}
+}
+
+void MinimumMeanCycleCalculator::run_stern_brocot(TJoinCalculator& calc, SearchState& state) {
+    auto const is_below = [&](Fraction const& fraction) {
+        return is_minimum_below(to_gamma(fraction), calc, state);
+    };
+    // Find the integer m with m <= minimum mean < m + 1
+    auto low = floor_div(state.lower_bound.cost_sum, state.lower_bound.num_edges);
+    auto high = floor_div(state.upper_bound.cost_sum, state.upper_bound.num_edges) + 1;
+    while (high - low > 1 and not is_within_tolerance(state)) {
+        auto const middle = low + (high - low) / 2;
+        if (is_below(Fraction{middle, 1})) {
+            high = middle;
+        } else {
+            low = middle;
+        }
+    }
+    // Descend the Stern–Brocot tree between the neighbours left <= minimum mean < right. Every fraction strictly between
+    // them has a denominator of at least the sum of their denominators. The minimum mean is the average of a cycle, so
+    // its denominator is at most the number of nodes: once the sum exceeds that, the minimum mean is left.
+    // Runs of steps in the same direction are found by exponential search, so long runs only cost logarithmically many
+    // T-join computations.
+    Fraction left{low, 1};
+    Fraction right{high, 1};
+    Int128 const max_denominator = state.max_cycle_length;
+    auto const combine = [](Fraction const& base, Fraction const& step, Int128 const times) {
+        return Fraction{base.numerator + times * step.numerator, base.denominator + times * step.denominator};
+    };
+    // Returns the largest k in [1, max_k] with valid(k), assuming valid(1) and monotonicity
+    auto const largest_valid = [](Int128 const max_k, auto const& valid) {
+        Int128 good = 1;
+        Int128 next = std::min<Int128>(2, max_k);
+        while (next > good and valid(next)) {
+            good = next;
+            next = std::min<Int128>(2 * good, max_k);
+        }
+        if (next == good) {
+            return good;
+        }
+        auto bad = next;
+        while (bad - good > 1) {
+            auto const middle = good + (bad - good) / 2;
+            if (valid(middle)) {
+                good = middle;
+            } else {
+                bad = middle;
             }
+        }
+        return good;
+    };
+    while (left.denominator + right.denominator <= max_denominator and not is_within_tolerance(state)) {
+        if (not is_below(combine(left, right, 1))) {
+            auto const max_k = (max_denominator - left.denominator) / right.denominator;
+            auto const steps = largest_valid(max_k, [&](Int128 const k) {
+                return not is_below(combine(left, right, k));
+            });
+            left = combine(left, right, steps);
         } else {
+            auto const max_k = (max_denominator - right.denominator) / left.denominator;
+            auto const steps = largest_valid(max_k, [&](Int128 const k) {
+                return is_below(combine(right, left, k));
+            });
+            right = combine(right, left, steps);
+        }
+    }
+    // Every answer "below right" came with a cycle cheaper than right, so the best cycle has mean in [left, right) and
+    // therefore is optimal. Fall back to Newton steps should that ever not hold (they stop at once if the search
+    // stopped early because of the tolerance).
+    if (state.upper_bound != to_gamma(left)) {
+        run_newton(calc, state);
+    }
+}
+
+void MinimumMeanCycleCalculator::run_hybrid(TJoinCalculator& calc, SearchState& state) {
+    auto const width = [&state] {
+        return static_cast<double>(state.upper_bound) - static_cast<double>(state.lower_bound);
+    };
+    while (not is_within_tolerance(state)) {
+        auto const width_before = width();
+        if (not is_minimum_below(state.upper_bound, calc, state)) {
             break;
         }
-    } while (gamma != gamma_last);
-    return std::make_pair(result_cycle, gamma);
+        if (width() > width_before / 2 and state.lower_bound < state.upper_bound) {
+            // Slow Newton step: test a simple fraction in the middle half of the bracket instead
+            auto const lower = to_fraction(state.lower_bound);
+            auto const upper = to_fraction(state.upper_bound);
+            auto const common_denominator = 4 * lower.denominator * upper.denominator;
+            auto const middle = simplest_fraction_between(
+                    Fraction{3 * lower.numerator * upper.denominator + upper.numerator * lower.denominator,
+                             common_denominator},
+                    Fraction{lower.numerator * upper.denominator + 3 * upper.numerator * lower.denominator,
+                             common_denominator}
+            );
+            is_minimum_below(to_gamma(middle), calc, state);
+        }
+    }
+}
+
+/// Splits the edge set into circuits by walking along unused edges and cutting off a circuit whenever the walk returns
+/// to a node on it. Linear in the number of edges (plus the number of nodes of the graph for the buffers).
+std::vector<std::vector<Edge>> MinimumMeanCycleCalculator::split_into_circuits(std::vector<Edge> const& edges) const {
+    auto const num_nodes = _graph.num_nodes();
+    std::vector<size_t> offsets(num_nodes + 1, 0);
+    for (auto const&[first, second] : edges) {
+        ++offsets[first + 1];
+        ++offsets[second + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    // Pairs of neighbor and index of the edge in edges
+    std::vector<std::pair<NodeId, size_t>> adjacency(2 * edges.size());
+    std::vector<size_t> next_position(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        adjacency[next_position[edges[i].first]++] = {edges[i].second, i};
+        adjacency[next_position[edges[i].second]++] = {edges[i].first, i};
+    }
+    std::copy(offsets.begin(), offsets.end() - 1, next_position.begin());
+
+    auto const not_on_walk = std::numeric_limits<size_t>::max();
+    std::vector<size_t> walk_position(num_nodes, not_on_walk);
+    std::vector<char> used(edges.size(), false);
+    struct WalkEntry {
+        NodeId node;
+        /// Index of the edge used to reach the node
+        size_t edge;
+    };
+    std::vector<WalkEntry> walk;
+    std::vector<std::vector<Edge>> circuits;
+    for (size_t first_edge = 0; first_edge < edges.size(); ++first_edge) {
+        if (used[first_edge]) {
+            continue;
+        }
+        walk.push_back(WalkEntry{edges[first_edge].first, not_on_walk});
+        walk_position[walk.back().node] = 0;
+        while (not walk.empty()) {
+            auto const current = walk.back().node;
+            auto& position = next_position[current];
+            while (position < offsets[current + 1] and used[adjacency[position].second]) {
+                ++position;
+            }
+            if (position == offsets[current + 1]) {
+                walk_position[current] = not_on_walk;
+                walk.pop_back();
+                continue;
+            }
+            auto const[next, edge] = adjacency[position];
+            used[edge] = true;
+            if (walk_position[next] != not_on_walk) {
+                std::vector<Edge> circuit{edges[edge]};
+                while (walk.size() > walk_position[next] + 1) {
+                    circuit.push_back(edges[walk.back().edge]);
+                    walk_position[walk.back().node] = not_on_walk;
+                    walk.pop_back();
+                }
+                circuits.push_back(std::move(circuit));
+            } else {
+                walk_position[next] = walk.size();
+                walk.push_back(WalkEntry{next, edge});
+            }
+        }
+    }
+    return circuits;
 }
 
 /// Find a circuit, using a crude heuristic for low mean cost: a DFS visiting cheap edges first
 std::optional<std::vector<Edge>>
 MinimumMeanCycleCalculator::find_heuristically_good_circuit(std::vector<Edge> const& edges) const {
-    std::set<NodeId> unvisited_nodes;
-    // Build a quick&dirty graph representation, with edges sorted by weight
-    std::map<NodeId, std::vector<NodeId>> edge_map;
-    for (auto const& edge_id : edges) {
-        std::array<NodeId, 2> ends{edge_id.first, edge_id.second};
-        for (size_t i = 0; i < ends.size(); ++i) {
-            unvisited_nodes.insert(ends[i]);
-            edge_map[ends[i]].push_back(ends[1 - i]);
-        }
+    auto const num_nodes = _graph.num_nodes();
+    // Build a compact adjacency list representation with the edges at every node sorted by weight per length. Sorting
+    // the edge list once and distributing it to the nodes in that order keeps every adjacency list sorted.
+    std::vector<Gamma> weights(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        auto const[weight, length] = weight_and_length(edges[i]);
+        weights[i] = Gamma{weight, length};
+    }
+    std::vector<size_t> by_weight(edges.size());
+    std::iota(by_weight.begin(), by_weight.end(), 0);
+    std::sort(by_weight.begin(), by_weight.end(), [&weights](size_t const a, size_t const b) {
+        return weights[a] < weights[b];
+    });
+    std::vector<size_t> offsets(num_nodes + 1, 0);
+    for (auto const&[first, second] : edges) {
+        ++offsets[first + 1];
+        ++offsets[second + 1];
     }
-    for (auto&[from, edges] : edge_map) {
-        std::sort(edges.begin(), edges.end(), [this, from = from](auto const& end_a, auto const& end_b) {
-            return _graph.edge_cost(Edge{from, end_a}) < _graph.edge_cost(Edge{from, end_b});
-        });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<NodeId> adjacency(2 * edges.size());
+    {
+        std::vector<size_t> next_free(offsets.begin(), offsets.end() - 1);
+        for (auto const edge_id : by_weight) {
+            auto const&[first, second] = edges[edge_id];
+            adjacency[next_free[first]++] = second;
+            adjacency[next_free[second]++] = first;
+        }
     }
     struct StackElement {
         NodeId current_node;
         size_t next_edge;
     };
-    while (not unvisited_nodes.empty()) {
-        auto const root = *unvisited_nodes.begin();
-        unvisited_nodes.erase(unvisited_nodes.begin());
-        std::vector<StackElement> stack{StackElement{root, 0}};
-        std::set<NodeId> in_stack{root};
+    std::vector<char> visited(num_nodes, false);
+    std::vector<char> in_stack(num_nodes, false);
+    std::vector<StackElement> stack;
+    for (NodeId root = 0; root < num_nodes; ++root) {
+        if (visited[root] or offsets[root] == offsets[root + 1]) {
+            continue;
+        }
+        visited[root] = true;
+        in_stack[root] = true;
+        stack.push_back(StackElement{root, offsets[root]});
         while (not stack.empty()) {
             auto& stack_top = stack.back();
-            auto const& edges_at_current = edge_map.at(stack_top.current_node);
-            if (stack_top.next_edge >= edges_at_current.size()) {
+            if (stack_top.next_edge >= offsets[stack_top.current_node + 1]) {
                 // Finished at current node
-                in_stack.erase(stack_top.current_node);
+                in_stack[stack_top.current_node] = false;
                 stack.pop_back();
                 continue;
             }
-            auto const& next = edges_at_current.at(stack_top.next_edge);
+            auto const next = adjacency[stack_top.next_edge];
             ++stack_top.next_edge;
             // Do not go back to the previous node
-            if (stack.size() > 1 and stack.at(stack.size() - 2).current_node == next) {
+            if (stack.size() > 1 and stack[stack.size() - 2].current_node == next) {
                 continue;
             }
-            if (in_stack.count(next)) {
+            if (in_stack[next]) {
                 // Found a cycle => return it
                 // We use a DFS, so any non-tree-edge is "inside" a path to the root of the tree
                 std::vector<Edge> circuit{Edge{stack_top.current_node, next}};
                 while (stack.back().current_node != next) {
-                    circuit.emplace_back(stack.back().current_node, stack.at(stack.size() - 2).current_node);
+                    circuit.emplace_back(stack.back().current_node, stack[stack.size() - 2].current_node);
                     stack.pop_back();
                 }
                 return circuit;
-            } else {
-                stack.push_back(StackElement{next, 0});
-                unvisited_nodes.erase(next);
-                in_stack.insert(next);
+            } else if (not visited[next]) {
+                visited[next] = true;
+                in_stack[next] = true;
+                stack.push_back(StackElement{next, offsets[next]});
             }
         }
     }
@@ -119,10 +559,21 @@ MinimumMeanCycleCalculator::find_heuristically_good_circuit(std::vector<Edge> co
 
 auto MinimumMeanCycleCalculator::get_average_cost(std::vector<Edge> const& edges) const -> Gamma {
     AccumulatedEdgeWeight total_cost = 0;
+    size_t total_length = 0;
     for (auto const& join_edge : edges) {
-        total_cost += _graph.edge_cost(join_edge);
+        auto const[weight, length] = weight_and_length(join_edge);
+        total_cost += weight;
+        total_length += length;
+    }
+    return Gamma{total_cost, total_length}.reduced();
+}
+
+std::pair<EdgeWeight, EdgeLength> MinimumMeanCycleCalculator::weight_and_length(Edge const& edge) const {
+    if (not _graph.has_edge_lengths()) {
+        return {_graph.edge_cost(edge), 1};
     }
-    return Gamma{total_cost, edges.size()};
+    auto const index = _graph.edge_index(edge);
+    return {_graph.edge_weight(index), _graph.edge_length(index)};
 }
 
 }
@@ -1,26 +1,185 @@
 #ifndef MINIMUMMEANCYCLE_MINIMUMMEANCYCLECALCULATOR_H
 #define MINIMUMMEANCYCLE_MINIMUMMEANCYCLECALCULATOR_H
 
+#include <optional>
 #include "graph.h"
 #include "Gamma.h"
+#include "Instrumentation.h"
+#include "Reduction.h"
+#include "TJoinCalculator.h"
 
 namespace MMC {
 
+/// How the next gamma (the candidate value for the minimum mean) is chosen. Every choice costs one T-join computation.
+enum class GammaSearchStrategy {
+    /// Always test the mean of the best known cycle, i.e. Newton's method on the parametric T-join cost
+    newton,
+    /**
+     * Exact bracketing: binary search over integers followed by a search in the Stern–Brocot tree. The minimum mean is
+     * a fraction with denominator at most the number of nodes, so the number of T-join computations is logarithmic in
+     * the weight range and the number of nodes.
+     */
+    stern_brocot,
+    /// Newton steps, with a bisection step (at the simplest fraction near the middle of the bracket) whenever a Newton
+    /// step did not halve the bracket
+    hybrid,
+};
+
+struct MinimumMeanCycleOptions {
+    GammaSearchStrategy search_strategy = GammaSearchStrategy::newton;
+    TJoinOptions t_join{};
+    /**
+     * Solve every block (biconnected component) with a cycle separately, which is exact since no cycle spans two
+     * blocks. Blocks are solved concurrently with t_join.num_threads threads; a block with at least a
+     * 1 / t_join.num_threads share of the edges is solved alone, using all threads for its shortest path computations.
+     */
+    bool decompose = true;
+    /**
+     * Remove the nodes of degree 1 and contract the paths through nodes of degree 2 to single edges before the search,
+     * see reduce_graph. Every T-join computation then runs on the smaller graph.
+     */
+    bool reduce = true;
+    /**
+     * Relative tolerance: the search stops as soon as the mean of the best known cycle exceeds the proven lower bound
+     * by at most epsilon times the larger absolute value of the two. 0 computes an exact minimum mean cycle.
+     */
+    double epsilon = 0;
+};
+
+/// What is known from an earlier solve of a similar graph, e.g. of the same graph before some weights changed
+struct SearchSeed {
+    /// A cycle of the graph, or empty. The search starts at its mean instead of at the mean of a heuristic cycle.
+    std::vector<Edge> cycle;
+    /// A proven lower bound on the minimum mean of the graph, if known
+    std::optional<Gamma> lower_bound;
+};
+
+/// Information on one T-join computation of find_mmc
+struct IterationStatistics {
+    Gamma gamma;
+    double seconds;
+    /// Is there a cycle with mean less than gamma?
+    bool found_cheaper_cycle;
+    /// Phase timings and counters of this iteration, all zero unless built with MMC_INSTRUMENTATION
+    Profile profile;
+};
+
 class MinimumMeanCycleCalculator {
 public:
-    explicit MinimumMeanCycleCalculator(Graph const& graph);
+    /// If a workspace is given, the T-join computations use its buffers instead of allocating their own
+    explicit MinimumMeanCycleCalculator(
+            Graph const& graph, MinimumMeanCycleOptions options = {}, TJoinWorkspace* workspace = nullptr
+    );
 
     std::optional<std::pair<std::vector<Edge>, Gamma>> find_mmc();
 
+    /**
+     * Like find_mmc(), but starts from what the seed knows. Only cycles with a smaller mean than the seed cycle are
+     * searched for, so confirming that the seed cycle is still optimal takes a single T-join computation for every
+     * block, or none at all if its mean equals the lower bound of the seed.
+     */
+    std::optional<std::pair<std::vector<Edge>, Gamma>> find_mmc(SearchSeed const& seed);
+
+    /**
+     * The lower bound on the minimum mean proven by the last call to find_mmc, only meaningful if it found a cycle.
+     * Equal to the mean of that cycle unless options.epsilon is positive.
+     */
+    [[nodiscard]] Gamma lower_bound() const;
+
+    /// Statistics on the matching solves of the last call to find_mmc
+    [[nodiscard]] MatchingStatistics const& matching_statistics() const;
+
+    /// One entry per T-join computation of the last call to find_mmc
+    [[nodiscard]] std::vector<IterationStatistics> const& iterations() const;
+
+    /// Phase timings and counters of the whole last call to find_mmc, all zero unless built with MMC_INSTRUMENTATION
+    [[nodiscard]] Profile const& profile() const;
+
 private:
+    /**
+     * A minimum mean cycle among the cycles with mean less than upper_limit (among all cycles if not given), or
+     * std::nullopt if there is none. lower_bound is a known lower bound on the minimum mean, if any.
+     */
+    std::optional<std::pair<std::vector<Edge>, Gamma>> find_mmc_below(
+            std::optional<Gamma> upper_limit, std::optional<Gamma> lower_bound
+    );
+
+    /// find_mmc_below for every given block of the graph (see find_cyclic_blocks), returns the best of their cycles
+    std::optional<std::pair<std::vector<Edge>, Gamma>> find_mmc_of_blocks(
+            std::vector<std::vector<EdgeIndex>> const& blocks, std::optional<Gamma> upper_limit,
+            std::optional<Gamma> lower_bound
+    );
+
+    /// find_mmc_below on the reduction of the graph, with the cycle expanded to the edges of the graph
+    std::optional<std::pair<std::vector<Edge>, Gamma>> find_mmc_of_reduction(
+            ReducedGraph const& reduced, std::optional<Gamma> upper_limit, std::optional<Gamma> lower_bound
+    );
+
+    /// State of the search for the minimum mean: the best known cycle and a lower bound on its mean
+    struct SearchState {
+        /// Empty while the upper bound is only the upper limit of find_mmc_below
+        std::vector<Edge> best_cycle;
+        Gamma upper_bound;
+        /// The minimum mean is at least this value
+        Gamma lower_bound;
+        /// An upper bound on the number of edges of a cycle, counting every edge with its length
+        size_t max_cycle_length;
+    };
+
+    /**
+     * Computes a minimum \emptyset-join for gamma. Returns true if there is a cycle with mean less than gamma, in that
+     * case the best cycle in the join replaces the best known cycle if it is better. Otherwise gamma is a lower bound.
+     */
+    bool has_cycle_below(Gamma gamma, TJoinCalculator& calc, SearchState& state);
+
+    /// Answers "is the minimum mean less than gamma?", using the known bounds where possible
+    bool is_minimum_below(Gamma gamma, TJoinCalculator& calc, SearchState& state);
+
+    /// Are the bounds close enough to stop, see MinimumMeanCycleOptions::epsilon?
+    [[nodiscard]] bool is_within_tolerance(SearchState const& state) const;
+
+    void run_newton(TJoinCalculator& calc, SearchState& state);
+
+    void run_stern_brocot(TJoinCalculator& calc, SearchState& state);
+
+    void run_hybrid(TJoinCalculator& calc, SearchState& state);
+
     [[nodiscard]] std::optional<std::vector<Edge>>
     find_heuristically_good_circuit(std::vector<Edge> const& edges) const;
 
+    /// Splits an edge set in which every node has even degree into edge-disjoint circuits
+    [[nodiscard]] std::vector<std::vector<Edge>> split_into_circuits(std::vector<Edge> const& edges) const;
+
+    /// The mean cost of the edges (their total weight divided by their total length), in lowest terms
     [[nodiscard]] Gamma get_average_cost(std::vector<Edge> const& edges) const;
 
+    [[nodiscard]] std::pair<EdgeWeight, EdgeLength> weight_and_length(Edge const& edge) const;
+
     Graph const& _graph;
+    MinimumMeanCycleOptions const _options;
+    TJoinWorkspace* const _workspace;
+    MatchingStatistics _matching_statistics;
+    std::vector<IterationStatistics> _iterations;
+    Profile _profile;
+    Gamma _lower_bound{0, 1};
 };
 
+inline Gamma MinimumMeanCycleCalculator::lower_bound() const {
+    return _lower_bound;
+}
+
+inline MatchingStatistics const& MinimumMeanCycleCalculator::matching_statistics() const {
+    return _matching_statistics;
+}
+
+inline std::vector<IterationStatistics> const& MinimumMeanCycleCalculator::iterations() const {
+    return _iterations;
+}
+
+inline Profile const& MinimumMeanCycleCalculator::profile() const {
+    return _profile;
+}
+
 }
 
 #endif //MINIMUMMEANCYCLE_MINIMUMMEANCYCLECALCULATOR_H
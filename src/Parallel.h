@@ -0,0 +1,73 @@
+#ifndef MINIMUMMEANCYCLE_PARALLEL_H
+#define MINIMUMMEANCYCLE_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Instrumentation.h"
+
+namespace MMC {
+
+/// Returns the number of threads to use if the user requested num_threads, where 0 means "all hardware threads"
+inline unsigned resolve_num_threads(unsigned const num_threads) {
+    if (num_threads != 0) {
+        return num_threads;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Calls body(item, thread_index) for every item in [0, num_items) using up to num_threads threads. Items are handed out
+ * one at a time in increasing order, so threads that finish early take over the remaining work. This balances the load
+ * even if the cost of the items differs a lot, as long as expensive items come first.
+ * thread_index is in [0, num_threads) and can be used to index per-thread buffers. The first exception thrown by body
+ * is rethrown after all threads have finished. The worker threads record into the profile recorder of the caller.
+ */
+template<class Body>
+void parallel_for_dynamic(size_t const num_items, unsigned const num_threads, Body const& body) {
+    auto const used_threads = static_cast<unsigned>(std::min<size_t>(num_threads, num_items));
+    if (used_threads <= 1) {
+        for (size_t item = 0; item < num_items; ++item) {
+            body(item, 0u);
+        }
+        return;
+    }
+    std::atomic<size_t> next_item{0};
+    std::exception_ptr first_exception;
+    std::mutex exception_mutex;
+    MMC_INSTRUMENT_ONLY(auto* const recorder = ProfileRecorder::current();)
+    auto const worker = [&](unsigned const thread_index) {
+        MMC_INSTRUMENT_RECORD_TO(recorder);
+        try {
+            for (size_t item = next_item++; item < num_items; item = next_item++) {
+                body(item, thread_index);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(exception_mutex);
+            if (not first_exception) {
+                first_exception = std::current_exception();
+            }
+            // Make the other threads stop early
+            next_item = num_items;
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(used_threads - 1);
+    for (unsigned i = 1; i < used_threads; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (first_exception) {
+        std::rethrow_exception(first_exception);
+    }
+}
+
+}
+
+#endif //MINIMUMMEANCYCLE_PARALLEL_H
@@ -0,0 +1,222 @@
+#include "Reduction.h" // always include corresponding header first
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_set>
+
+namespace MMC {
+
+namespace {
+
+/// A path between two kept nodes without kept inner nodes, which becomes one edge of the reduced graph
+struct Segment {
+    NodeId first;
+    NodeId second;
+    AccumulatedEdgeWeight weight;
+    /// The edges of the path are path_edges[begin], ..., path_edges[end - 1]
+    size_t begin;
+    size_t end;
+};
+
+bool fits_edge_weight(AccumulatedEdgeWeight const weight) {
+    return weight >= std::numeric_limits<EdgeWeight>::min() and weight <= std::numeric_limits<EdgeWeight>::max();
+}
+
+uint64_t node_pair_key(NodeId const first, NodeId const second) {
+    auto const&[lower, higher] = std::minmax(first, second);
+    return static_cast<uint64_t>(lower) << 32 | higher;
+}
+
+} // end of anonymous namespace
+
+std::vector<Edge> ReducedGraph::expand(std::vector<Edge> const& cycle) const {
+    std::vector<Edge> expanded;
+    for (auto const& edge : cycle) {
+        auto const index = graph.edge_index(edge);
+        expanded.insert(
+                expanded.end(), original_edges.begin() + original_edge_offsets[index],
+                original_edges.begin() + original_edge_offsets[index + 1]
+        );
+    }
+    return expanded;
+}
+
+std::optional<ReducedGraph> reduce_graph(Graph const& graph) {
+    auto const num_nodes = graph.num_nodes();
+    // Remove leaves until there are none left, removing a leaf may turn its neighbor into one
+    std::vector<NodeId> degree(num_nodes);
+    std::vector<char> removed(graph.num_edges(), false);
+    std::vector<NodeId> leaves;
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        degree[node] = graph.degree(node);
+        if (degree[node] == 1) {
+            leaves.push_back(node);
+        }
+    }
+    bool const has_leaves = not leaves.empty();
+    while (not leaves.empty()) {
+        auto const leaf = leaves.back();
+        leaves.pop_back();
+        if (degree[leaf] != 1) {
+            // The other end of an isolated edge
+            continue;
+        }
+        for (auto const& incidence : graph.incidences(leaf)) {
+            if (not removed[incidence.edge]) {
+                removed[incidence.edge] = true;
+                degree[leaf] = 0;
+                if (--degree[incidence.neighbor] == 1) {
+                    leaves.push_back(incidence.neighbor);
+                }
+                break;
+            }
+        }
+    }
+
+    // Every remaining edge is on a path between two nodes of degree at least 3 whose inner nodes have degree 2, or on
+    // a component that is a cycle. Walk along these paths and split them into segments.
+    std::vector<char> kept(num_nodes, false);
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        kept[node] = degree[node] > 2;
+    }
+    std::vector<char> walked(graph.num_edges(), false);
+    std::vector<NodeId> path_nodes;
+    std::vector<EdgeIndex> path_edges;
+    std::vector<Segment> segments;
+    std::unordered_set<uint64_t> contracted_pairs;
+    auto const walk_path = [&](NodeId const start, Incidence const& first) {
+        path_nodes.push_back(start);
+        auto current = first;
+        while (true) {
+            walked[current.edge] = true;
+            path_edges.push_back(current.edge);
+            path_nodes.push_back(current.neighbor);
+            if (kept[current.neighbor]) {
+                break;
+            }
+            for (auto const& incidence : graph.incidences(current.neighbor)) {
+                if (not removed[incidence.edge] and incidence.edge != current.edge) {
+                    current = incidence;
+                    break;
+                }
+            }
+        }
+    };
+    // Splits the path last walked into segments, at the inner nodes at positions with keep_inner(position) and
+    // wherever the weight of a segment would not fit into an EdgeWeight
+    auto const split_path = [&](size_t const first_node, size_t const first_edge, auto const& keep_inner) {
+        auto const num_edges = path_edges.size() - first_edge;
+        size_t begin = 0;
+        AccumulatedEdgeWeight weight = 0;
+        for (size_t i = 0; i <= num_edges; ++i) {
+            auto const edge_weight = i < num_edges ? graph.edge_weight(path_edges[first_edge + i]) : 0;
+            if (i == num_edges or (i > begin and (keep_inner(i) or not fits_edge_weight(weight + edge_weight)))) {
+                kept[path_nodes[first_node + i]] = true;
+                segments.push_back(Segment{
+                        path_nodes[first_node + begin], path_nodes[first_node + i], weight, first_edge + begin,
+                        first_edge + i
+                });
+                begin = i;
+                weight = 0;
+            }
+            weight += edge_weight;
+        }
+    };
+    auto const contract_path = [&](NodeId const start, Incidence const& first) {
+        auto const first_node = path_nodes.size();
+        auto const first_edge = path_edges.size();
+        walk_path(start, first);
+        auto const num_edges = path_edges.size() - first_edge;
+        auto const end = path_nodes.back();
+        if (end == start) {
+            // Keep two inner nodes, the cycle has at least three edges since there are no parallel edges
+            split_path(first_node, first_edge, [num_edges](size_t const i) { return i == 1 or i == num_edges - 1; });
+            return;
+        }
+        auto const num_segments = segments.size();
+        split_path(first_node, first_edge, [](size_t) { return false; });
+        if (num_edges == 1 or segments.size() > num_segments + 1) {
+            return;
+        }
+        if (graph.edge_exists(Edge{start, end}) or not contracted_pairs.insert(node_pair_key(start, end)).second) {
+            // The contracted path would be parallel to another edge, keep its first inner node
+            segments.pop_back();
+            split_path(first_node, first_edge, [](size_t const i) { return i == 1; });
+        }
+    };
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        if (not kept[node]) {
+            continue;
+        }
+        for (auto const& incidence : graph.incidences(node)) {
+            if (not removed[incidence.edge] and not walked[incidence.edge]) {
+                contract_path(node, incidence);
+            }
+        }
+    }
+    // The remaining edges form components that are cycles, they are reduced to triangles
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        if (kept[node] or degree[node] == 0) {
+            continue;
+        }
+        auto const first = std::find_if(
+                graph.incidences(node).begin(), graph.incidences(node).end(),
+                [&removed](Incidence const& incidence) { return not removed[incidence.edge]; }
+        );
+        if (not walked[(*first).edge]) {
+            kept[node] = true;
+            contract_path(node, *first);
+        }
+    }
+    bool const has_long_segments = std::any_of(segments.begin(), segments.end(), [](Segment const& segment) {
+        return segment.end - segment.begin > 1;
+    });
+    if (not has_leaves and not has_long_segments) {
+        return std::nullopt;
+    }
+
+    std::vector<NodeId> original_nodes;
+    std::vector<NodeId> reduced_id(num_nodes, 0);
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        if (kept[node]) {
+            reduced_id[node] = static_cast<NodeId>(original_nodes.size());
+            original_nodes.push_back(node);
+        }
+    }
+    std::vector<Edge> edges;
+    std::vector<EdgeWeight> weights;
+    std::vector<EdgeLength> lengths;
+    edges.reserve(segments.size());
+    weights.reserve(segments.size());
+    lengths.reserve(segments.size());
+    for (auto const& segment : segments) {
+        edges.emplace_back(reduced_id[segment.first], reduced_id[segment.second]);
+        weights.push_back(static_cast<EdgeWeight>(segment.weight));
+        lengths.push_back(static_cast<EdgeLength>(segment.end - segment.begin));
+    }
+    if (not has_long_segments) {
+        lengths.clear();
+    }
+    auto const storage = has_long_segments ? GraphStorage::sparse : graph.storage();
+    auto const num_reduced_nodes = static_cast<NodeId>(original_nodes.size());
+    ReducedGraph reduced{Graph(num_reduced_nodes, edges, weights, storage, lengths), std::move(original_nodes), {}, {}};
+
+    // The graph sorts its edges, so look up where every segment went
+    std::vector<size_t> segment_of_edge(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) {
+        segment_of_edge[reduced.graph.edge_index(edges[i])] = i;
+    }
+    reduced.original_edge_offsets.reserve(segments.size() + 1);
+    reduced.original_edge_offsets.push_back(0);
+    reduced.original_edges.reserve(path_edges.size());
+    for (auto const segment_id : segment_of_edge) {
+        auto const& segment = segments[segment_id];
+        for (auto i = segment.begin; i < segment.end; ++i) {
+            reduced.original_edges.push_back(graph.edge(path_edges[i]));
+        }
+        reduced.original_edge_offsets.push_back(reduced.original_edges.size());
+    }
+    return reduced;
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef MINIMUMMEANCYCLE_REDUCTION_H
+#define MINIMUMMEANCYCLE_REDUCTION_H
+
+#include <optional>
+#include <vector>
+#include "graph.h"
+
+namespace MMC {
+
+/// A graph with its tree-like fringes removed and its paths through nodes of degree 2 contracted to single edges
+struct ReducedGraph {
+    /// Edge i stands for a path of edge_length(i) original edges with total weight edge_weight(i)
+    Graph graph;
+    /// Node v of graph is node original_nodes[v] of the original graph. Increasing, so the order of edge ends is kept.
+    std::vector<NodeId> original_nodes;
+    /// The original edges of edge i of graph are original_edges[original_edge_offsets[i]], ...,
+    /// original_edges[original_edge_offsets[i + 1] - 1]
+    std::vector<size_t> original_edge_offsets;
+    std::vector<Edge> original_edges;
+
+    /// Replaces every edge of a cycle of graph by the edges of the original graph it stands for
+    [[nodiscard]] std::vector<Edge> expand(std::vector<Edge> const& cycle) const;
+};
+
+/**
+ * Removes nodes of degree 1 until there are none left, since their edges are on no cycle, and contracts every path
+ * whose inner nodes have degree 2 into a single edge with the total weight and the number of edges of the path as
+ * length. The mean weight of every cycle, as total weight divided by total length, stays the same.
+ *
+ * Inner nodes are kept where needed to keep the graph simple (a path parallel to an edge or to another contracted path,
+ * a path from a node back to itself, a component that is a cycle) and to keep the contracted weights within the range
+ * of EdgeWeight. The result is stored like graph if all its edges have length 1 and sparse otherwise.
+ * Returns std::nullopt if nothing can be removed or contracted.
+ */
+[[nodiscard]] std::optional<ReducedGraph> reduce_graph(Graph const& graph);
+
+}
+
+#endif //MINIMUMMEANCYCLE_REDUCTION_H
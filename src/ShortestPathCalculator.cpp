@@ -1,22 +1,110 @@
 #include "ShortestPathCalculator.h"
+#include <algorithm>
 #include <cassert>
-#include <iostream>
+#include <limits>
+#include "DenseKernels.h"
 
 namespace MMC {
 
-ShortestPathCalculator::ShortestPathCalculator(
-        NodeId const source, MMC::Graph const& graph, Gamma cost_transform
+namespace {
+
+constexpr AccumulatedEdgeWeight unreached = std::numeric_limits<AccumulatedEdgeWeight>::max();
+
+}
+
+template<class Heap>
+BasicShortestPathCalculator<Heap>::BasicShortestPathCalculator(
+        NodeId const source, MMC::Graph const& graph, Gamma cost_transform,
+        BasicDijkstraWorkspace<Heap>* const workspace
+) : BasicShortestPathCalculator(std::vector<NodeId>{source}, graph, cost_transform, workspace) {}
+
+template<class Heap>
+BasicShortestPathCalculator<Heap>::BasicShortestPathCalculator(
+        std::vector<NodeId> const& sources, MMC::Graph const& graph, Gamma cost_transform,
+        BasicDijkstraWorkspace<Heap>* const workspace
 ) : _graph(graph),
     _cost_transform(cost_transform),
-    _source(source),
-    _node_data(_graph.num_nodes()) {
-    NodeData empty_node_data{0, std::numeric_limits<AccumulatedEdgeWeight>::max(), false};
-    std::fill(_node_data.begin(), _node_data.end(), empty_node_data);
-    _node_data.at(source).distance = 0;
-    _heap.push(HeapEntry{source, 0});
+    _own_workspace(workspace ? nullptr : std::make_unique<BasicDijkstraWorkspace<Heap>>()),
+    _workspace(workspace ? *workspace : *_own_workspace),
+    _node_data(_workspace.node_data),
+    _distances(_workspace.distances),
+    _heap(_workspace.heap) {
+    assert(not _workspace.in_use);
+    _workspace.in_use = true;
+    if (_node_data.size() != _graph.num_nodes()) {
+        _node_data.assign(_graph.num_nodes(), NodeData{0, 0, false});
+        _distances.assign(_graph.num_nodes(), unreached);
+    }
+    assert(_heap.empty() and _workspace.touched.empty());
+    for (auto const source : sources) {
+        add_source(source);
+    }
+}
+
+template<class Heap>
+BasicShortestPathCalculator<Heap>::~BasicShortestPathCalculator() {
+    MMC_INSTRUMENT_COUNT(heap_pushes, _num_heap_pushes);
+    MMC_INSTRUMENT_COUNT(stale_heap_pops, _num_stale_heap_pops);
+    for (auto const node : _workspace.touched) {
+        _node_data[node] = NodeData{0, 0, false};
+        _distances[node] = unreached;
+    }
+    _workspace.touched.clear();
+    _heap.clear();
+    _workspace.in_use = false;
 }
 
-std::optional<NodeId> ShortestPathCalculator::fix_next_node() {
+template<class Heap>
+typename BasicShortestPathCalculator<Heap>::NodeData& BasicShortestPathCalculator<Heap>::touch(NodeId const node) {
+    if (_distances[node] == unreached) {
+        _workspace.touched.push_back(node);
+    }
+    return _node_data[node];
+}
+
+template<class Heap>
+void BasicShortestPathCalculator<Heap>::push(NodeId const node, AccumulatedEdgeWeight const distance) {
+    _heap.push(node, distance);
+    MMC_INSTRUMENT_ONLY(++_num_heap_pushes);
+}
+
+template<class Heap>
+void BasicShortestPathCalculator<Heap>::improve(
+        NodeId const node, AccumulatedEdgeWeight const distance, NodeId const last
+) {
+    auto& data = touch(node);
+    _distances[node] = distance;
+    data.last = last;
+    data.source = _node_data[last].source;
+    push(node, distance);
+}
+
+template<class Heap>
+void BasicShortestPathCalculator<Heap>::add_source(NodeId const source) {
+    auto& source_data = touch(source);
+    _distances[source] = 0;
+    source_data.last = source;
+    source_data.source = source;
+    push(source, 0);
+}
+
+template<class Heap>
+uint32_t BasicShortestPathCalculator<Heap>::next_target_epoch() {
+    auto& target_marks = _workspace.target_marks;
+    if (target_marks.size() != _graph.num_nodes() or _workspace.target_epoch == std::numeric_limits<uint32_t>::max()) {
+        target_marks.assign(_graph.num_nodes(), 0);
+        _workspace.target_epoch = 0;
+    }
+    return ++_workspace.target_epoch;
+}
+
+template<class Heap>
+void BasicShortestPathCalculator<Heap>::run_to_completion() {
+    while (fix_next_node()) {}
+}
+
+template<class Heap>
+std::optional<NodeId> BasicShortestPathCalculator<Heap>::fix_next_node() {
     auto const next_id_to_fix_opt = extract_next_unfixed_node();
     if (not next_id_to_fix_opt) {
         return std::nullopt;
@@ -24,53 +112,114 @@ std::optional<NodeId> ShortestPathCalculator::fix_next_node() {
     auto const next_id_to_fix = next_id_to_fix_opt.value();
     _node_data.at(next_id_to_fix).fixed = true;
 
-    auto const distance_to_fixed = _node_data.at(next_id_to_fix).distance;
-    for (NodeId other_end = 0; other_end < _graph.num_nodes(); ++other_end) {
-        auto& end_data = _node_data.at(other_end);
-        if (end_data.fixed) {
-            continue;
+    auto const distance_to_fixed = _distances[next_id_to_fix];
+    if (_graph.storage() == GraphStorage::dense) {
+        // Relax the whole matrix row with vector instructions. Fixed nodes are never improved, as their distance is at
+        // most distance_to_fixed.
+        auto const row = _graph.matrix_row(next_id_to_fix);
+        auto& improved = _workspace.improved;
+        improved.clear();
+        find_improving_neighbors(
+                row, _graph.matrix_row_exists(next_id_to_fix), _graph.num_nodes(), distance_to_fixed,
+                _cost_transform, _distances.data(), improved
+        );
+        for (auto const neighbor : improved) {
+            improve(neighbor, distance_to_fixed + std::abs(_cost_transform.apply(row[neighbor])), next_id_to_fix);
         }
-        // Order of the vertices in the edge is logically irrelevant, but highly important for performance due to CPU
-        // caches
-        Edge const edge{next_id_to_fix, other_end,};
-        if (not _graph.edge_exists(edge)) {
-            continue;
+        return next_id_to_fix;
+    }
+    if (_graph.storage() == GraphStorage::compact_dense) {
+        if (_graph.narrow_matrix()) {
+            relax_compact_matrix_row<int16_t>(next_id_to_fix, distance_to_fixed);
+        } else {
+            relax_compact_matrix_row<int32_t>(next_id_to_fix, distance_to_fixed);
         }
-        auto const edge_weight = std::abs(_cost_transform.apply(_graph.edge_cost(edge)));
-        auto const distance_via_node = distance_to_fixed + edge_weight;
-        if (end_data.distance > distance_via_node) {
-            end_data.distance = distance_via_node;
-            end_data.last = next_id_to_fix;
-            _heap.push(HeapEntry{other_end, distance_via_node});
+        return next_id_to_fix;
+    }
+    auto const neighbors = _graph.neighbors(next_id_to_fix);
+    // As in the row kernels, fixed nodes need not be skipped explicitly, the distance comparison never improves them
+    auto const relax_neighbors = [&](auto const& edge_length) {
+        for (auto const& incidence : neighbors) {
+            auto const edge_weight = std::abs(_cost_transform.apply(incidence.weight, edge_length(incidence)));
+            auto const distance_via_node = distance_to_fixed + edge_weight;
+            if (_distances[incidence.neighbor] > distance_via_node) {
+                improve(incidence.neighbor, distance_via_node, next_id_to_fix);
+            }
         }
+    };
+    if (_graph.has_edge_lengths()) {
+        auto const lengths = _graph.edge_lengths().data();
+        relax_neighbors([lengths](Incidence const& incidence) { return lengths[incidence.edge]; });
+    } else {
+        relax_neighbors([](Incidence const&) { return EdgeLength{1}; });
     }
     return next_id_to_fix;
 }
 
-std::optional<Path> ShortestPathCalculator::make_path(NodeId const target) const {
+template<class Heap>
+template<class Weight>
+void BasicShortestPathCalculator<Heap>::relax_compact_matrix_row(
+        NodeId const node, AccumulatedEdgeWeight const distance
+) {
+    // The entry of node itself holds the sentinel for missing edges, so the whole row can be scanned
+    auto const row = _graph.compact_matrix_row<Weight>(node);
+    auto& improved = _workspace.improved;
+    improved.clear();
+    find_improving_neighbors(row, _graph.num_nodes(), distance, _cost_transform, _distances.data(), improved);
+    for (auto const neighbor : improved) {
+        improve(neighbor, distance + std::abs(_cost_transform.apply(row[neighbor])), node);
+    }
+}
+
+template<class Heap>
+std::optional<Path> BasicShortestPathCalculator<Heap>::make_path(NodeId const target) const {
     if (not _node_data.at(target).fixed) {
         return std::nullopt;
     }
     std::vector<Edge> edges;
+    append_path_edges(target, edges);
+    return Path{std::move(edges), _distances[target]};
+}
+
+template<class Heap>
+void BasicShortestPathCalculator<Heap>::append_path_edges(NodeId const target, std::vector<Edge>& edges) const {
+    assert(_node_data.at(target).fixed);
     auto current_node = target;
-    while (current_node != _source) {
-        auto const& current_data = _node_data.at(current_node);
+    while (current_node != _node_data[current_node].last) {
+        auto const& current_data = _node_data[current_node];
         auto const&[lower, higher] = std::minmax(current_data.last, current_node);
         edges.emplace_back(lower, higher);
         current_node = current_data.last;
     }
-    return Path{std::move(edges), _node_data.at(target).distance};
 }
 
-std::optional<NodeId> ShortestPathCalculator::extract_next_unfixed_node() {
+template<class Heap>
+std::optional<NodeId> BasicShortestPathCalculator<Heap>::extract_next_unfixed_node() {
     while (not _heap.empty()) {
         auto const to_fix = _heap.top().node;
         _heap.pop();
         if (not _node_data.at(to_fix).fixed) {
             return to_fix;
         }
+        MMC_INSTRUMENT_ONLY(++_num_stale_heap_pops);
     }
     return std::nullopt;
 }
 
+template<class Heap>
+std::optional<AccumulatedEdgeWeight> BasicShortestPathCalculator<Heap>::next_distance() {
+    while (not _heap.empty()) {
+        auto const& top = _heap.top();
+        if (not _node_data[top.node].fixed) {
+            return top.distance;
+        }
+        _heap.pop();
+        MMC_INSTRUMENT_ONLY(++_num_stale_heap_pops);
+    }
+    return std::nullopt;
+}
+
+template class BasicShortestPathCalculator<BinaryHeap>;
+template class BasicShortestPathCalculator<RadixHeap>;
+
 }
@@ -1,11 +1,14 @@
 #ifndef MINIMUMMEANCYCLE_SHORTESTPATHCALCULATOR_H
 #define MINIMUMMEANCYCLE_SHORTESTPATHCALCULATOR_H
 
+#include <limits>
+#include <memory>
 #include <vector>
 #include <optional>
-#include <queue>
 #include "graph.h"
-#include "MinimumMeanCycleCalculator.h"
+#include "DijkstraHeap.h"
+#include "Gamma.h"
+#include "Instrumentation.h"
 
 namespace MMC {
 
@@ -15,24 +18,101 @@ struct Path {
     AccumulatedEdgeWeight path_cost;
 };
 
+template<class Heap>
+class BasicShortestPathCalculator;
+
+/**
+ * The memory used by a ShortestPathCalculator: per-node labels and the heap. A workspace can be passed to consecutive
+ * calculators (one at a time) to avoid allocating and initializing O(num_nodes) memory for every run. After a
+ * calculator is destroyed, only the labels it touched are reset, so a run that explores a small part of the graph is
+ * cheap even on a large graph.
+ */
+template<class Heap>
+class BasicDijkstraWorkspace {
+private:
+    friend class BasicShortestPathCalculator<Heap>;
+
+    struct NodeData {
+        /// Previous node on the shortest path, the node itself for sources
+        NodeId last;
+        /// First node of the shortest path
+        NodeId source;
+        /// Is the current distance known to be optimal?
+        bool fixed;
+    };
+
+    /// Either empty or num_nodes entries, all of which are in the initial state except for the touched ones
+    std::vector<NodeData> node_data;
+    /// Distance from the source on the current shortest path of every node. Stored separately from node_data, so that
+    /// the relaxation of a dense row can compare them with vector instructions.
+    std::vector<AccumulatedEdgeWeight> distances;
+    /// Nodes improved by the relaxation of a dense row, reused to avoid allocations
+    std::vector<NodeId> improved;
+    /// Empty unless a calculator is running
+    Heap heap;
+    /// Nodes whose labels were changed by the current calculator
+    std::vector<NodeId> touched;
+    /// The targets of a call to run_until_found are the nodes with target_marks[node] == target_epoch. Starting a new
+    /// epoch replaces the targets in O(1) instead of clearing the marks.
+    std::vector<uint32_t> target_marks;
+    uint32_t target_epoch = 0;
+    bool in_use = false;
+};
+
 /**
- * An implementation of Dijkstra's algorithm. It uses a std::priority_queue as the heap. Since this structure does not
- * have an equivalent of decrease_key, nodes are (potentially) added to the heap multiple times. The first extracted
- * occurrence of a node is the one with the shortest distance, all further occurrences will be ignored.
+ * An implementation of Dijkstra's algorithm. The heap (see DijkstraHeap.h) has no decrease_key, so nodes are
+ * (potentially) added to the heap multiple times. The first extracted occurrence of a node is the one with the shortest
+ * distance, all further occurrences will be ignored.
  */
-class ShortestPathCalculator {
+template<class Heap>
+class BasicShortestPathCalculator {
 public:
     /**
      * Initialize the path calculator with the given source and graph. The costs used are abs(cost_transform.apply(-)).
+     * If a workspace is given, its memory is used instead of allocating new memory. It must not be used by any other
+     * calculator during the lifetime of this one.
+     */
+    BasicShortestPathCalculator(
+            NodeId source, Graph const& graph, Gamma cost_transform, BasicDijkstraWorkspace<Heap>* workspace = nullptr
+    );
+
+    /**
+     * Initialize the path calculator with multiple sources. Distances are distances to the closest source, paths start
+     * at the closest source.
      */
-    ShortestPathCalculator(NodeId source, Graph const& graph, Gamma cost_transform);
+    BasicShortestPathCalculator(
+            std::vector<NodeId> const& sources, Graph const& graph, Gamma cost_transform,
+            BasicDijkstraWorkspace<Heap>* workspace = nullptr
+    );
+
+    /// Resets the touched labels of the workspace (and reports the heap counters to the profile recorder of the
+    /// calling thread if instrumentation is enabled)
+    ~BasicShortestPathCalculator();
+
+    BasicShortestPathCalculator(BasicShortestPathCalculator const&) = delete;
+
+    BasicShortestPathCalculator& operator=(BasicShortestPathCalculator const&) = delete;
 
     /**
-     * Run Dijkstra's algorithm until all nodes in the given iterator range have been found or all reachable nodes have
-     * been marked
+     * Run Dijkstra's algorithm until all nodes in the given iterator range have been found, all reachable nodes have
+     * been marked or the next node to be marked is farther than max_distance. Checking whether a marked node is a
+     * target takes constant time.
      */
     template<class Iterator>
-    void run_until_found(Iterator const& targets_begin, Iterator const& targets_end);
+    void run_until_found(
+            Iterator const& targets_begin, Iterator const& targets_end,
+            AccumulatedEdgeWeight max_distance = std::numeric_limits<AccumulatedEdgeWeight>::max()
+    );
+
+    /**
+     * Run Dijkstra's algorithm until all nodes with distance at most max_distance have been marked. on_fixed(node) is
+     * called for every node marked by this call.
+     */
+    template<class Callback>
+    void run_up_to_distance(AccumulatedEdgeWeight max_distance, Callback const& on_fixed);
+
+    /// Run Dijkstra's algorithm until all reachable nodes have been marked
+    void run_to_completion();
 
     /**
      * Create a path object representing the shortest path found by Dijkstra's algorithm. Returns an empty optional if
@@ -41,24 +121,20 @@ public:
      */
     [[nodiscard]] std::optional<Path> make_path(NodeId target) const;
 
-private:
-    struct NodeData {
-        /// Previous node on the shortest path
-        NodeId last;
-        /// Distance from the source on the shortest path
-        AccumulatedEdgeWeight distance;
-        /// Is the current distance known to be optimal?
-        bool fixed;
-    };
+    /// Appends the edges of the shortest path to target (which has to be marked) to the given vector
+    void append_path_edges(NodeId target, std::vector<Edge>& edges) const;
 
-    struct HeapEntry {
-        NodeId node;
-        AccumulatedEdgeWeight distance;
+    /// Has the shortest path to this node been found by previous calls to run_until_found/run_up_to_distance?
+    [[nodiscard]] bool is_fixed(NodeId node) const;
 
-        bool operator>(HeapEntry const& other) const {
-            return distance > other.distance;
-        }
-    };
+    /// The length of the shortest path to this node, only valid if the node is fixed
+    [[nodiscard]] AccumulatedEdgeWeight distance(NodeId node) const;
+
+    /// The source at which the shortest path to this node starts, only valid if the node is fixed
+    [[nodiscard]] NodeId closest_source(NodeId node) const;
+
+private:
+    using NodeData = typename BasicDijkstraWorkspace<Heap>::NodeData;
 
     /**
      * Runs one iteration of Dijkstra's algorithm. Returns the node whose distance was fixes if one was fixed. If no
@@ -69,27 +145,100 @@ private:
     /// Extract nodes from the heap until an unfixed node is found, returns std::nullopt if none is found
     std::optional<NodeId> extract_next_unfixed_node();
 
+    /// Discards fixed nodes from the top of the heap and returns the distance of the next node to be fixed
+    std::optional<AccumulatedEdgeWeight> next_distance();
+
+    void add_source(NodeId source);
+
+    /// Starts a new epoch of _workspace.target_marks, i.e. unmarks all targets, and returns it
+    uint32_t next_target_epoch();
+
+    void push(NodeId node, AccumulatedEdgeWeight distance);
+
+    /// Sets a new tentative distance of node, reached via the fixed node last
+    void improve(NodeId node, AccumulatedEdgeWeight distance, NodeId last);
+
+    /// Relaxes all edges of node, stored as a row of the compact matrix of the graph
+    template<class Weight>
+    void relax_compact_matrix_row(NodeId node, AccumulatedEdgeWeight distance);
+
+    /// The label of node for writing, registers the node as touched
+    NodeData& touch(NodeId node);
+
     Graph const& _graph;
     Gamma const _cost_transform;
-    NodeId const _source;
-    std::vector<NodeData> _node_data;
-    std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<>> _heap;
+    /// Only set if no workspace was passed to the constructor
+    std::unique_ptr<BasicDijkstraWorkspace<Heap>> const _own_workspace;
+    BasicDijkstraWorkspace<Heap>& _workspace;
+    std::vector<NodeData>& _node_data;
+    std::vector<AccumulatedEdgeWeight>& _distances;
+    Heap& _heap;
+#ifdef MMC_INSTRUMENTATION
+    uint64_t _num_heap_pushes = 0;
+    uint64_t _num_stale_heap_pops = 0;
+#endif
 };
 
+/// The weights abs(gamma.apply(w)) are non-negative integers, for which the radix heap is fastest
+using DijkstraWorkspace = BasicDijkstraWorkspace<RadixHeap>;
+using ShortestPathCalculator = BasicShortestPathCalculator<RadixHeap>;
+
+extern template class BasicShortestPathCalculator<BinaryHeap>;
+extern template class BasicShortestPathCalculator<RadixHeap>;
+
+template<class Heap>
 template<class Iterator>
-inline void ShortestPathCalculator::run_until_found(Iterator const& targets_begin, Iterator const& targets_end) {
-    auto const num_targets = static_cast<size_t>(std::distance(targets_begin, targets_end));
-    size_t num_targets_found = 0;
-    while (auto const& fixed_node = fix_next_node()) {
-        if (std::find(targets_begin, targets_end, *fixed_node) != targets_end) {
-            ++num_targets_found;
-            if (num_targets_found == num_targets) {
-                break;
-            }
+inline void BasicShortestPathCalculator<Heap>::run_until_found(
+        Iterator const& targets_begin, Iterator const& targets_end, AccumulatedEdgeWeight const max_distance
+) {
+    auto const epoch = next_target_epoch();
+    auto& target_marks = _workspace.target_marks;
+    size_t num_targets_left = 0;
+    for (auto target = targets_begin; target != targets_end; ++target) {
+        if (target_marks[*target] != epoch and not _node_data[*target].fixed) {
+            target_marks[*target] = epoch;
+            ++num_targets_left;
+        }
+    }
+    while (num_targets_left > 0) {
+        auto const next = next_distance();
+        if (not next or *next > max_distance) {
+            break;
+        }
+        if (target_marks[*fix_next_node()] == epoch) {
+            --num_targets_left;
+        }
+    }
+}
+
+template<class Heap>
+template<class Callback>
+inline void BasicShortestPathCalculator<Heap>::run_up_to_distance(
+        AccumulatedEdgeWeight const max_distance, Callback const& on_fixed
+) {
+    while (auto const next = next_distance()) {
+        if (*next > max_distance) {
+            break;
         }
+        on_fixed(*fix_next_node());
     }
 }
 
+template<class Heap>
+inline bool BasicShortestPathCalculator<Heap>::is_fixed(NodeId const node) const {
+    return _node_data[node].fixed;
+}
+
+template<class Heap>
+inline AccumulatedEdgeWeight BasicShortestPathCalculator<Heap>::distance(NodeId const node) const {
+    return _distances[node];
+}
+
+template<class Heap>
+inline NodeId BasicShortestPathCalculator<Heap>::closest_source(NodeId const node) const {
+    return _node_data[node].source;
+}
+
 }
 
 #endif //MINIMUMMEANCYCLE_SHORTESTPATHCALCULATOR_H
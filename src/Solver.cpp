@@ -0,0 +1,205 @@
+#include "Solver.h" // always include corresponding header first
+#include <algorithm>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace MMC {
+
+namespace {
+
+/// Writes the cycle as a DIMACS graph with the given problem format and type of edge lines, see write_cycle
+template<class EdgeCost>
+void write_cycle_lines(
+        std::ostream& output, char const* const format, char const line_type, NodeId const num_nodes,
+        std::optional<MinimumMeanCycle> const& cycle, std::optional<Gamma> const& lower_bound,
+        EdgeCost const& edge_cost
+) {
+    if (cycle and lower_bound) {
+        output << "c upper_bound " << cycle->second.cost_sum << '/' << cycle->second.num_edges << '\n'
+               << "c lower_bound " << lower_bound->cost_sum << '/' << lower_bound->num_edges << '\n';
+    }
+    output << "p " << format << ' ' << num_nodes << ' ';
+    if (cycle) {
+        // Write edges of minimum mean cycle
+        auto const& edges = cycle->first;
+        output << edges.size() << '\n';
+        for (auto const& edge : edges) {
+            output << line_type << ' ';
+            for (auto const end : {edge.first, edge.second}) {
+                output << (end + 1) << ' ';
+            }
+            output << edge_cost(edge) << '\n';
+        }
+    } else {
+        // Graph is acyclic
+        output << "0\n";
+    }
+}
+
+AccumulatedEdgeWeight weight_decrease(EdgeWeight const old_weight, EdgeWeight const new_weight) {
+    return std::max<AccumulatedEdgeWeight>(0, AccumulatedEdgeWeight{old_weight} - new_weight);
+}
+
+/// lower_bound - decrease / 3, or std::nullopt if that does not fit into a Gamma
+std::optional<Gamma> lowered_by_a_third(Gamma const lower_bound, AccumulatedEdgeWeight const decrease) {
+    __extension__ using Int128 = __int128;
+    auto const numerator = 3 * static_cast<Int128>(lower_bound.cost_sum)
+                           - static_cast<Int128>(decrease) * static_cast<Int128>(lower_bound.num_edges);
+    auto const denominator = 3 * static_cast<Int128>(lower_bound.num_edges);
+    if (numerator < std::numeric_limits<AccumulatedEdgeWeight>::min()
+        or numerator > std::numeric_limits<AccumulatedEdgeWeight>::max()
+        or denominator > std::numeric_limits<AccumulatedEdgeWeight>::max()) {
+        return std::nullopt;
+    }
+    return Gamma{static_cast<AccumulatedEdgeWeight>(numerator), static_cast<size_t>(denominator)}.reduced();
+}
+
+} // end of anonymous namespace
+
+void write_cycle(
+        std::ostream& output, Graph const& graph, std::optional<MinimumMeanCycle> const& cycle,
+        std::optional<Gamma> const& lower_bound
+) {
+    write_cycle_lines(output, "edge", 'e', graph.num_nodes(), cycle, lower_bound, [&graph](Edge const& edge) {
+        return graph.edge_cost(edge);
+    });
+}
+
+void write_cycle(std::ostream& output, Digraph const& graph, std::optional<MinimumMeanCycle> const& cycle) {
+    write_cycle_lines(output, "sp", 'a', graph.num_nodes(), cycle, std::nullopt, [&graph](Edge const& arc) {
+        return graph.arc_cost(arc);
+    });
+}
+
+Solver::Solver(MinimumMeanCycleOptions const options) : _options(options) {}
+
+void Solver::set_options(MinimumMeanCycleOptions const& options) {
+    _options = options;
+}
+
+void Solver::set_graph(Graph graph) {
+    _graph.reset();
+    _graph.emplace(std::move(graph));
+    _seed = SearchSeed{};
+}
+
+void Solver::read_graph(std::string const& path, GraphStorage const storage) {
+    // Release the old graph first, the new one may be large
+    _graph.reset();
+    _seed = SearchSeed{};
+    _graph.emplace(Graph::read_file(path, storage, _options.t_join.num_threads));
+}
+
+void Solver::clear_graph() {
+    _graph.reset();
+    _seed = SearchSeed{};
+}
+
+Graph const& Solver::graph() const {
+    if (not _graph) {
+        throw std::runtime_error("The solver has no graph.");
+    }
+    return *_graph;
+}
+
+void Solver::set_edge_weights(std::vector<EdgeWeight> const& weights) {
+    if (not _graph) {
+        throw std::runtime_error("The solver has no graph.");
+    }
+    if (weights.size() == _graph->num_edges()) {
+        for (EdgeIndex i = 0; i < weights.size(); ++i) {
+            _weight_decrease += weight_decrease(_graph->edge_weight(i), weights[i]);
+        }
+    }
+    _graph->set_edge_weights(weights);
+}
+
+void Solver::update_edge_weights(std::vector<EdgeWeightUpdate> const& updates) {
+    if (not _graph) {
+        throw std::runtime_error("The solver has no graph.");
+    }
+    auto& graph = *_graph;
+    for (auto const& update : updates) {
+        if (not graph.edge_exists(update.edge)) {
+            throw std::runtime_error("Cannot update the weight of a missing edge.");
+        }
+    }
+    for (auto const& update : updates) {
+        auto const index = graph.edge_index(update.edge);
+        _weight_decrease += weight_decrease(graph.edge_weight(index), update.weight);
+        graph.set_edge_weight(index, update.weight);
+    }
+}
+
+void Solver::insert_edges(std::vector<Edge> const& edges, std::vector<EdgeWeight> const& weights) {
+    if (edges.size() != weights.size()) {
+        throw std::runtime_error("Number of weights does not match the number of edges!");
+    }
+    auto const& graph = this->graph();
+    std::vector<Edge> all_edges;
+    std::vector<EdgeWeight> all_weights(graph.edge_weights());
+    all_edges.reserve(graph.num_edges() + edges.size());
+    all_weights.reserve(graph.num_edges() + edges.size());
+    for (EdgeIndex i = 0; i < graph.num_edges(); ++i) {
+        all_edges.push_back(graph.edge(i));
+    }
+    all_edges.insert(all_edges.end(), edges.begin(), edges.end());
+    all_weights.insert(all_weights.end(), weights.begin(), weights.end());
+    rebuild_graph(std::move(all_edges), all_weights);
+    // The new edges may close cheaper cycles, the seed cycle remains a valid start
+    _seed.lower_bound.reset();
+}
+
+void Solver::remove_edges(std::vector<Edge> const& edges) {
+    auto const& graph = this->graph();
+    std::vector<char> removed(graph.num_edges(), false);
+    for (auto const& edge : edges) {
+        if (not graph.edge_exists(edge)) {
+            throw std::runtime_error("Cannot remove a missing edge.");
+        }
+        removed[graph.edge_index(edge)] = true;
+    }
+    // Removing edges removes cycles, so only the seed cycle may become invalid
+    for (auto const& edge : _seed.cycle) {
+        if (removed[graph.edge_index(edge)]) {
+            _seed.cycle.clear();
+            break;
+        }
+    }
+    std::vector<Edge> kept_edges;
+    std::vector<EdgeWeight> kept_weights;
+    for (EdgeIndex i = 0; i < graph.num_edges(); ++i) {
+        if (not removed[i]) {
+            kept_edges.push_back(graph.edge(i));
+            kept_weights.push_back(graph.edge_weight(i));
+        }
+    }
+    rebuild_graph(std::move(kept_edges), kept_weights);
+}
+
+void Solver::rebuild_graph(std::vector<Edge> edges, std::vector<EdgeWeight> const& weights) {
+    // Build the new graph before releasing the old one, so that the old one is kept if the edges are invalid
+    Graph graph(_graph->num_nodes(), std::move(edges), weights, _graph->storage());
+    _graph.reset();
+    _graph.emplace(std::move(graph));
+}
+
+std::optional<MinimumMeanCycle> Solver::solve() {
+    MinimumMeanCycleCalculator calculator(graph(), _options, &_workspace);
+    auto seed = _seed;
+    if (seed.lower_bound and _weight_decrease > 0) {
+        seed.lower_bound = lowered_by_a_third(*seed.lower_bound, _weight_decrease);
+    }
+    auto result = calculator.find_mmc(seed);
+    _seed.cycle = result ? result->first : std::vector<Edge>{};
+    _seed.lower_bound = result ? std::optional<Gamma>(calculator.lower_bound()) : std::nullopt;
+    _weight_decrease = 0;
+    _lower_bound = calculator.lower_bound();
+    _matching_statistics = calculator.matching_statistics();
+    _iterations = calculator.iterations();
+    _profile = calculator.profile();
+    return result;
+}
+
+}
@@ -0,0 +1,150 @@
+#ifndef MINIMUMMEANCYCLE_SOLVER_H
+#define MINIMUMMEANCYCLE_SOLVER_H
+
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+#include "Digraph.h"
+#include "graph.h"
+#include "Gamma.h"
+#include "MinimumMeanCycleCalculator.h"
+#include "TJoinCalculator.h"
+
+namespace MMC {
+
+/// A minimum mean cycle (edges in arbitrary order, lower node ID first) and its mean weight
+using MinimumMeanCycle = std::pair<std::vector<Edge>, Gamma>;
+
+/**
+ * Writes the cycle as a DIMACS graph: "p edge <num nodes of graph> <num cycle edges>" followed by one "e" line per
+ * cycle edge. An acyclic graph (no cycle) is written as a graph without edges. If a lower bound on the minimum mean is
+ * given (see MinimumMeanCycleOptions::epsilon), the comment lines "c upper_bound <mean of the cycle>" and
+ * "c lower_bound <lower bound>" come first, with both values as exact fractions "<numerator>/<denominator>".
+ */
+void write_cycle(
+        std::ostream& output, Graph const& graph, std::optional<MinimumMeanCycle> const& cycle,
+        std::optional<Gamma> const& lower_bound = std::nullopt
+);
+
+/**
+ * Writes a cycle of a digraph (its arcs as (tail, head) pairs, see DirectedMinimumMeanCycleCalculator) like write_cycle
+ * does for graphs, but in DIMACS arc format: "p sp <num nodes of graph> <num cycle arcs>" followed by one "a" line per
+ * arc.
+ */
+void write_cycle(std::ostream& output, Digraph const& graph, std::optional<MinimumMeanCycle> const& cycle);
+
+/// A new weight for the edge between the given nodes
+struct EdgeWeightUpdate {
+    Edge edge;
+    EdgeWeight weight;
+};
+
+/**
+ * Entry point for embedding the solver. A Solver owns the current graph and the buffers used by the computation
+ * (Dijkstra labels and heaps, distance tables), which are kept between calls. Solving many graphs, or the same graph
+ * with different weights, thus only allocates when a graph is larger than all previous ones.
+ *
+ * Changes to a solved graph (its weights or edges) keep what is still known: the last cycle found seeds the next
+ * solve as long as all its edges exist, and so does the lower bound proven by the last solve, lowered by a third of the
+ * total weight decrease since (every cycle has at least three edges), as long as no edges were inserted. Confirming
+ * that the last cycle is still optimal thus takes one T-join computation per block, see SearchSeed.
+ *
+ * A Solver is not thread safe, use one per thread to solve graphs concurrently.
+ */
+class Solver {
+public:
+    explicit Solver(MinimumMeanCycleOptions options = {});
+
+    [[nodiscard]] MinimumMeanCycleOptions const& options() const;
+
+    void set_options(MinimumMeanCycleOptions const& options);
+
+    /// Replaces the current graph
+    void set_graph(Graph graph);
+
+    /// Replaces the current graph by the one in the given file, in DIMACS or binary format
+    void read_graph(std::string const& path, GraphStorage storage = GraphStorage::sparse);
+
+    /// Releases the current graph, keeping the buffers for the next one
+    void clear_graph();
+
+    [[nodiscard]] bool has_graph() const;
+
+    /// The current graph, throws if there is none
+    [[nodiscard]] Graph const& graph() const;
+
+    /// Changes the weights of the current graph, weights[i] becomes the weight of graph().edge(i)
+    void set_edge_weights(std::vector<EdgeWeight> const& weights);
+
+    /// Changes the weights of some edges of the current graph in place, in time O(log(degree)) per edge
+    void update_edge_weights(std::vector<EdgeWeightUpdate> const& updates);
+
+    /**
+     * Adds edges between existing nodes of the current graph, weights[i] is the weight of edges[i]. The graph is
+     * rebuilt, so the edge indices change. Throws (and keeps the graph) if an edge already exists.
+     */
+    void insert_edges(std::vector<Edge> const& edges, std::vector<EdgeWeight> const& weights);
+
+    /// Removes edges of the current graph. The graph is rebuilt, so the edge indices change. Throws if one is missing.
+    void remove_edges(std::vector<Edge> const& edges);
+
+    /// Computes a minimum mean cycle of the current graph, an empty optional if the graph is acyclic
+    std::optional<MinimumMeanCycle> solve();
+
+    /// The lower bound on the minimum mean proven by the last solve, see MinimumMeanCycleCalculator::lower_bound
+    [[nodiscard]] Gamma lower_bound() const;
+
+    /// Statistics on the matching solves of the last call to solve
+    [[nodiscard]] MatchingStatistics const& matching_statistics() const;
+
+    /// One entry per T-join computation of the last call to solve
+    [[nodiscard]] std::vector<IterationStatistics> const& iterations() const;
+
+    /// Phase timings and counters of the last call to solve, all zero unless built with MMC_INSTRUMENTATION
+    [[nodiscard]] Profile const& profile() const;
+
+private:
+    /// Replaces the current graph by one with the same nodes and storage, keeping the seed
+    void rebuild_graph(std::vector<Edge> edges, std::vector<EdgeWeight> const& weights);
+
+    MinimumMeanCycleOptions _options;
+    std::optional<Graph> _graph;
+    /// What the last solve proved about the current graph, kept up to date with its changes
+    SearchSeed _seed;
+    /// Sum of all weight decreases since the last solve, which the lower bound of _seed does not account for yet
+    AccumulatedEdgeWeight _weight_decrease = 0;
+    TJoinWorkspace _workspace;
+    Gamma _lower_bound{0, 1};
+    MatchingStatistics _matching_statistics;
+    std::vector<IterationStatistics> _iterations;
+    Profile _profile;
+};
+
+inline MinimumMeanCycleOptions const& Solver::options() const {
+    return _options;
+}
+
+inline bool Solver::has_graph() const {
+    return _graph.has_value();
+}
+
+inline Gamma Solver::lower_bound() const {
+    return _lower_bound;
+}
+
+inline MatchingStatistics const& Solver::matching_statistics() const {
+    return _matching_statistics;
+}
+
+inline std::vector<IterationStatistics> const& Solver::iterations() const {
+    return _iterations;
+}
+
+inline Profile const& Solver::profile() const {
+    return _profile;
+}
+
+}
+
+#endif //MINIMUMMEANCYCLE_SOLVER_H
@@ -1,38 +1,302 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
-#include <map>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <tuple>
 #include "TJoinCalculator.h"
+#include "DenseKernels.h"
 #include "ShortestPathCalculator.h"
+#include "Parallel.h"
+#include "WidePerfectMatching.h"
 #include "blossomv/PerfectMatching.h"
 
 namespace MMC {
 
-TJoinCalculator::TJoinCalculator(Graph const& baseGraph) : _base_graph(baseGraph) {}
+namespace {
 
-TJoin MMC::TJoinCalculator::get_minimum_zero_join(Gamma const cost_transform) const {
-    // Find all negative edges and mark nodes as odd accordingly
-    std::vector<bool> node_is_odd(_base_graph.num_nodes(), false);
-    std::vector<Edge> negative_edges;
-    for (NodeId lower = 0; lower < _base_graph.num_nodes(); ++lower) {
-        for (NodeId upper = lower + 1; upper < _base_graph.num_nodes(); ++upper) {
-            Edge const edge{lower, upper};
-            if (_base_graph.edge_exists(edge) and cost_transform.apply(_base_graph.edge_cost(edge)) < 0) {
-                for (auto const end : {lower, upper}) {
-                    node_is_odd[end] = not node_is_odd[end];
-                }
-                negative_edges.push_back(edge);
+/**
+ * Largest matching cost passed to Blossom V, which is compiled with int costs. It works with twice the costs and duals
+ * internally, so a margin is kept. Instances with larger costs are solved by WidePerfectMatching.
+ */
+constexpr AccumulatedEdgeWeight max_blossom_cost = std::numeric_limits<int>::max() / 4;
+
+/// Sorts the join and removes pairs of equal edges, i.e. keeps every edge with odd multiplicity exactly once
+void remove_duplicate_pairs(TJoin& join) {
+    std::sort(join.begin(), join.end());
+    auto it = join.begin();
+    while (it != join.end() and it + 1 != join.end()) {
+        if (*it == *(it + 1)) {
+            it = join.erase(it, it + 2);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/// Disjoint set forest with path halving and union by size
+class UnionFind {
+public:
+    explicit UnionFind(size_t size) : _parent(size), _size(size, 1) {
+        std::iota(_parent.begin(), _parent.end(), 0);
+    }
+
+    size_t find(size_t element) {
+        while (_parent[element] != element) {
+            _parent[element] = _parent[_parent[element]];
+            element = _parent[element];
+        }
+        return element;
+    }
+
+    /// Returns false if both elements already were in the same set
+    bool unite(size_t a, size_t b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) {
+            return false;
+        }
+        if (_size[a] < _size[b]) {
+            std::swap(a, b);
+        }
+        _parent[b] = a;
+        _size[a] += _size[b];
+        return true;
+    }
+
+private:
+    std::vector<size_t> _parent;
+    std::vector<size_t> _size;
+};
+
+/// An edge connecting the Voronoi regions of two odd nodes. The walk through it is an upper bound on their distance.
+struct Candidate {
+    /// Indices of the odd nodes
+    size_t lower;
+    size_t higher;
+    AccumulatedEdgeWeight cost;
+    EdgeIndex edge;
+};
+
+/**
+ * Returns the cheapest candidate for every pair of adjacent Voronoi regions, sorted by the pair. regions has to be run
+ * to completion from all odd nodes, terminal_index maps odd nodes to their index.
+ */
+std::vector<Candidate> collect_region_candidates(
+        Graph const& graph, ShortestPathCalculator const& regions, std::vector<size_t> const& terminal_index,
+        Gamma const cost_transform
+) {
+    std::vector<Candidate> candidates;
+    for (EdgeIndex i = 0; i < graph.num_edges(); ++i) {
+        auto const&[first, second] = graph.edge(i);
+        if (not regions.is_fixed(first)) {
+            // Not in the same connected component as any odd node
+            continue;
+        }
+        auto const first_terminal = terminal_index[regions.closest_source(first)];
+        auto const second_terminal = terminal_index[regions.closest_source(second)];
+        if (first_terminal == second_terminal) {
+            continue;
+        }
+        auto const edge_cost = std::abs(cost_transform.apply(graph.edge_weight(i), graph.edge_length(i)));
+        auto const cost = regions.distance(first) + edge_cost + regions.distance(second);
+        auto const&[lower, higher] = std::minmax(first_terminal, second_terminal);
+        candidates.push_back(Candidate{lower, higher, cost, i});
+    }
+    std::sort(candidates.begin(), candidates.end(), [](Candidate const& a, Candidate const& b) {
+        return std::tie(a.lower, a.higher, a.cost) < std::tie(b.lower, b.higher, b.cost);
+    });
+    candidates.erase(std::unique(candidates.begin(), candidates.end(), [](Candidate const& a, Candidate const& b) {
+        return a.lower == b.lower and a.higher == b.higher;
+    }), candidates.end());
+    return candidates;
+}
+
+/// Kruskal's algorithm on the candidates. Returns the IDs of the forest candidates incident to every odd node.
+std::vector<std::vector<size_t>> minimum_spanning_forest(std::vector<Candidate> const& candidates, size_t num_odd) {
+    std::vector<size_t> by_cost(candidates.size());
+    std::iota(by_cost.begin(), by_cost.end(), 0);
+    std::sort(by_cost.begin(), by_cost.end(), [&candidates](size_t const a, size_t const b) {
+        return candidates[a].cost < candidates[b].cost;
+    });
+    std::vector<std::vector<size_t>> forest_edges(num_odd);
+    UnionFind components(num_odd);
+    for (auto const candidate_id : by_cost) {
+        auto const& candidate = candidates[candidate_id];
+        if (components.unite(candidate.lower, candidate.higher)) {
+            forest_edges[candidate.lower].push_back(candidate_id);
+            forest_edges[candidate.higher].push_back(candidate_id);
+        }
+    }
+    return forest_edges;
+}
+
+/// Bounds for pruning pairs of odd nodes in the all-pairs strategy
+struct PairBounds {
+    /// The cost of some T-join, i.e. an upper bound on the cost of a minimum perfect matching of the odd nodes
+    AccumulatedEdgeWeight upper_bound = 0;
+    /// The distance of every odd node to the nearest other odd node
+    std::vector<AccumulatedEdgeWeight> nearest;
+};
+
+/**
+ * Computes the bounds from the Voronoi regions of the odd nodes: the distance to the nearest other odd node is the
+ * cheapest candidate of the region, and the upper bound is the T-join in the minimum spanning forest of the candidates.
+ */
+PairBounds compute_pair_bounds(
+        Graph const& graph, std::vector<NodeId> const& odd_nodes, Gamma const cost_transform,
+        DijkstraWorkspace& workspace
+) {
+    auto const no_terminal = std::numeric_limits<size_t>::max();
+    std::vector<size_t> terminal_index(graph.num_nodes(), no_terminal);
+    for (size_t i = 0; i < odd_nodes.size(); ++i) {
+        terminal_index[odd_nodes[i]] = i;
+    }
+    ShortestPathCalculator regions(odd_nodes, graph, cost_transform, &workspace);
+    regions.run_to_completion();
+    auto const candidates = collect_region_candidates(graph, regions, terminal_index, cost_transform);
+
+    PairBounds bounds;
+    bounds.nearest.assign(odd_nodes.size(), std::numeric_limits<AccumulatedEdgeWeight>::max());
+    for (auto const& candidate : candidates) {
+        for (auto const end : {candidate.lower, candidate.higher}) {
+            bounds.nearest[end] = std::min(bounds.nearest[end], candidate.cost);
+        }
+    }
+    // A forest edge is in the T-join iff the subtree below it contains an odd number of odd nodes
+    auto const forest_edges = minimum_spanning_forest(candidates, odd_nodes.size());
+    std::vector<size_t> parent(odd_nodes.size(), no_terminal);
+    std::vector<size_t> parent_candidate(odd_nodes.size(), no_terminal);
+    std::vector<char> odd_subtree(odd_nodes.size(), 1);
+    std::vector<size_t> preorder;
+    for (size_t root = 0; root < odd_nodes.size(); ++root) {
+        if (parent[root] != no_terminal) {
+            continue;
+        }
+        parent[root] = root;
+        preorder.clear();
+        preorder.push_back(root);
+        for (size_t i = 0; i < preorder.size(); ++i) {
+            auto const current = preorder[i];
+            for (auto const candidate_id : forest_edges[current]) {
+                auto const& candidate = candidates[candidate_id];
+                auto const next = candidate.lower == current ? candidate.higher : candidate.lower;
+                if (parent[next] == no_terminal) {
+                    parent[next] = current;
+                    parent_candidate[next] = candidate_id;
+                    preorder.push_back(next);
+                }
+            }
+        }
+        for (auto it = preorder.rbegin(); it != preorder.rend() and *it != root; ++it) {
+            if (odd_subtree[*it]) {
+                bounds.upper_bound += candidates[parent_candidate[*it]].cost;
+                odd_subtree[parent[*it]] ^= 1;
             }
         }
     }
-    assert(std::is_sorted(negative_edges.begin(), negative_edges.end()));
-    // Create set/vector of odd nodes
+    return bounds;
+}
+
+} // end of anonymous namespace
+
+double MatchingStatistics::estimated_seconds_saved() const {
+    if (num_cold_solves == 0) {
+        return 0;
+    }
+    auto const average_cold_seconds = cold_solve_seconds / static_cast<double>(num_cold_solves);
+    return average_cold_seconds * static_cast<double>(num_warm_solves) - warm_solve_seconds;
+}
+
+MatchingStatistics& MatchingStatistics::operator+=(MatchingStatistics const& other) {
+    num_cold_solves += other.num_cold_solves;
+    num_warm_solves += other.num_warm_solves;
+    cold_solve_seconds += other.cold_solve_seconds;
+    warm_solve_seconds += other.warm_solve_seconds;
+    return *this;
+}
+
+TJoinCalculator::TJoinCalculator(Graph const& baseGraph, TJoinOptions const options, TJoinWorkspace* const workspace)
+        : _base_graph(baseGraph),
+          _options(options),
+          _own_workspace(workspace ? nullptr : std::make_unique<TJoinWorkspace>()),
+          _workspace(workspace ? *workspace : *_own_workspace) {
+    _workspace.dijkstra.resize(std::max<size_t>(_workspace.dijkstra.size(), resolve_num_threads(_options.num_threads)));
+    auto const& weights = _base_graph.edge_weights();
+    if (not weights.empty()) {
+        auto const[min_weight, max_weight] = std::minmax_element(weights.begin(), weights.end());
+        _min_weight = *min_weight;
+        _max_weight = *max_weight;
+    }
+    auto const& lengths = _base_graph.edge_lengths();
+    if (not lengths.empty()) {
+        _max_length = *std::max_element(lengths.begin(), lengths.end());
+    }
+}
+
+void TJoinCalculator::check_cost_range(Gamma const cost_transform) const {
+    // Shortest paths have at most n - 1 edges and the walks through candidate edges of the Voronoi strategy at most
+    // 2 n - 1. Twice their costs are compared in the pruning and pricing bounds, and if they do not fit into Blossom V,
+    // they are matched by WidePerfectMatching, whose range is the smaller one.
+    __extension__ using Int128 = __int128;
+    auto const max_edge_cost = _max_length == 1
+            ? std::max(
+                    std::abs(static_cast<Int128>(_min_weight) * cost_transform.num_edges - cost_transform.cost_sum),
+                    std::abs(static_cast<Int128>(_max_weight) * cost_transform.num_edges - cost_transform.cost_sum)
+            )
+            : std::max(std::abs(static_cast<Int128>(_min_weight)), std::abs(static_cast<Int128>(_max_weight)))
+              * cost_transform.num_edges + std::abs(static_cast<Int128>(cost_transform.cost_sum)) * _max_length;
+    static_assert(4 * Int128{WidePerfectMatching::max_cost} <= std::numeric_limits<AccumulatedEdgeWeight>::max());
+    if ((2 * Int128{_base_graph.num_nodes()} - 1) * max_edge_cost > WidePerfectMatching::max_cost) {
+        throw std::runtime_error(
+                "Path costs for gamma = " + std::to_string(cost_transform.cost_sum) + "/"
+                + std::to_string(cost_transform.num_edges) + " may exceed the range of the 64 bit matching"
+        );
+    }
+}
+
+TJoinCalculator::~TJoinCalculator() = default;
+
+TJoin MMC::TJoinCalculator::get_minimum_zero_join(Gamma const cost_transform) {
+    check_cost_range(cost_transform);
+    std::vector<Edge> negative_edges;
     std::vector<NodeId> odd_nodes;
-    for (NodeId i = 0; i < _base_graph.num_nodes(); ++i) {
-        if (node_is_odd.at(i)) {
-            odd_nodes.push_back(i);
+    {
+        MMC_INSTRUMENT_PHASE(negative_edge_scan);
+        // Find all negative edges (with a vectorized scan of the weights) and mark nodes as odd accordingly
+        std::vector<EdgeIndex> negative_edge_indices;
+        auto const& weights = _base_graph.edge_weights();
+        if (_base_graph.has_edge_lengths()) {
+            for (EdgeIndex i = 0; i < weights.size(); ++i) {
+                if (cost_transform.apply(weights[i], _base_graph.edge_length(i)) < 0) {
+                    negative_edge_indices.push_back(i);
+                }
+            }
+        } else {
+            find_negative_weights(weights.data(), weights.size(), cost_transform, negative_edge_indices);
+        }
+        std::vector<bool> node_is_odd(_base_graph.num_nodes(), false);
+        negative_edges.reserve(negative_edge_indices.size());
+        for (auto const i : negative_edge_indices) {
+            auto const& edge = _base_graph.edge(i);
+            for (auto const end : {edge.first, edge.second}) {
+                node_is_odd[end] = not node_is_odd[end];
+            }
+            negative_edges.push_back(edge);
+        }
+        assert(std::is_sorted(negative_edges.begin(), negative_edges.end()));
+        // Create set/vector of odd nodes
+        for (NodeId i = 0; i < _base_graph.num_nodes(); ++i) {
+            if (node_is_odd.at(i)) {
+                odd_nodes.push_back(i);
+            }
         }
     }
+    MMC_INSTRUMENT_COUNT(odd_nodes, odd_nodes.size());
     auto base_result = get_minimum_cost_t_join_abs(odd_nodes, cost_transform);
+    MMC_INSTRUMENT_PHASE(join_extraction);
     // Take symmetric difference of the negative edges and the join. By ensuring that both joins are sorted we can make
     // use of std::set_symmetric_difference, which has linear runtime (and saves me from having to implement it)
     std::sort(base_result.begin(), base_result.end());
@@ -47,49 +311,426 @@ TJoin MMC::TJoinCalculator::get_minimum_zero_join(Gamma const cost_transform) co
 
 TJoin TJoinCalculator::get_minimum_cost_t_join_abs(
         std::vector<NodeId> const& odd_nodes, Gamma const cost_transform
-) const {
-    // Calculate shortest paths between all pairs of odd nodes
-    // Map keys are pairs of indices in odd_nodes, with the first entry of the pair being smaller than the second
-    std::map<std::pair<size_t, size_t>, Path> paths;
-    for (size_t lower = 0; lower < odd_nodes.size(); ++lower) {
-        ShortestPathCalculator calc(odd_nodes.at(lower), _base_graph, cost_transform);
-        calc.run_until_found(odd_nodes.begin() + lower + 1, odd_nodes.end());
-        for (size_t higher = lower + 1; higher < odd_nodes.size(); ++higher) {
-            if (auto const path = calc.make_path(odd_nodes.at(higher))) {
-                paths.insert({std::make_pair(lower, higher), *path});
+) {
+    switch (_options.strategy) {
+        case TJoinStrategy::voronoi_pricing:
+            return get_minimum_cost_t_join_voronoi(odd_nodes, cost_transform);
+        case TJoinStrategy::all_pairs:
+        default:
+            return get_minimum_cost_t_join_all_pairs(odd_nodes, cost_transform);
+    }
+}
+
+TJoin TJoinCalculator::get_minimum_cost_t_join_all_pairs(
+        std::vector<NodeId> const& odd_nodes, Gamma const cost_transform
+) {
+    // Calculate the distances between all pairs of odd nodes. Only the distances are stored, in a flat upper triangular
+    // matrix indexed by pairs of indices in odd_nodes. The runs for different sources are independent and write to
+    // disjoint entries of the matrix.
+    auto const num_odd = odd_nodes.size();
+    auto const pair_index = [num_odd](size_t const lower, size_t const higher) {
+        return lower * (2 * num_odd - lower - 1) / 2 + (higher - lower - 1);
+    };
+    auto const no_path = std::numeric_limits<AccumulatedEdgeWeight>::max();
+    auto& distances = _workspace.distances;
+    distances.assign(num_odd * (num_odd - 1) / 2, no_path);
+    auto const num_threads = resolve_num_threads(_options.num_threads);
+    // With pruning, a matching containing the pair (a, b) costs at least dist(a, b) + (sum(nearest) - nearest(a)
+    // - nearest(b)) / 2, as every other pair costs at least the mean of the nearest distances of its ends. If that
+    // exceeds the upper bound, (a, b) is in no minimum matching and does not have to be found.
+    std::optional<PairBounds> bounds;
+    AccumulatedEdgeWeight twice_gap = 0;
+    std::vector<AccumulatedEdgeWeight> max_nearest_after(num_odd + 1, 0);
+    auto const twice_pruning_threshold = [&](size_t const lower, size_t const higher) {
+        return twice_gap + bounds->nearest[lower] + bounds->nearest[higher];
+    };
+    {
+        MMC_INSTRUMENT_PHASE(dijkstra);
+        if (_options.prune_pairs and num_odd > 2) {
+            bounds = compute_pair_bounds(_base_graph, odd_nodes, cost_transform, _workspace.regions);
+            twice_gap = 2 * bounds->upper_bound
+                        - std::accumulate(bounds->nearest.begin(), bounds->nearest.end(), AccumulatedEdgeWeight{0});
+            for (size_t i = num_odd; i-- > 0;) {
+                max_nearest_after[i] = std::max(max_nearest_after[i + 1], bounds->nearest[i]);
             }
         }
+        parallel_for_dynamic(num_odd, num_threads, [&](size_t const lower, unsigned const thread_index) {
+            ShortestPathCalculator calc(
+                    odd_nodes[lower], _base_graph, cost_transform, &_workspace.dijkstra[thread_index]
+            );
+            auto const max_distance =
+                    bounds ? (twice_gap + bounds->nearest[lower] + max_nearest_after[lower + 1]) / 2 : no_path;
+            calc.run_until_found(odd_nodes.begin() + lower + 1, odd_nodes.end(), max_distance);
+            for (size_t higher = lower + 1; higher < num_odd; ++higher) {
+                if (not calc.is_fixed(odd_nodes[higher])) {
+                    continue;
+                }
+                auto const distance = calc.distance(odd_nodes[higher]);
+                if (not bounds or 2 * distance <= twice_pruning_threshold(lower, higher)) {
+                    distances[pair_index(lower, higher)] = distance;
+                }
+            }
+        });
     }
-    //Build and solve maximum matching instance
-    PerfectMatching solver{static_cast<int>(odd_nodes.size()), static_cast<int>(paths.size())};
-    for (auto const&[key, path] : paths) {
-        solver.AddEdge(key.first, key.second, path.path_cost);
+    //Build and solve maximum matching instance. If the odd nodes did not change since the last call and every pair
+    // found now is an edge of the previous matching, that matching can be reused by updating the costs of its edges.
+    auto const start_time = std::chrono::steady_clock::now();
+    auto const pairs_are_subset_of_last = [&] {
+        size_t last_pair = 0;
+        for (size_t lower = 0; lower < num_odd; ++lower) {
+            for (size_t higher = lower + 1; higher < num_odd; ++higher) {
+                if (distances[pair_index(lower, higher)] == no_path) {
+                    continue;
+                }
+                while (last_pair < _last_pairs.size() and _last_pairs[last_pair] < std::make_pair(lower, higher)) {
+                    ++last_pair;
+                }
+                if (last_pair == _last_pairs.size() or _last_pairs[last_pair] != std::make_pair(lower, higher)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    auto const num_pairs = static_cast<size_t>(std::count_if(
+            distances.begin(), distances.end(), [no_path](auto const distance) { return distance != no_path; }
+    ));
+    MMC_INSTRUMENT_COUNT(pruned_pairs, bounds ? distances.size() - num_pairs : 0);
+    AccumulatedEdgeWeight max_cost = 0;
+    for (auto const distance : distances) {
+        if (distance != no_path) {
+            max_cost = std::max(max_cost, distance);
+        }
     }
-    solver.Solve();
+    bool const wide_costs = max_cost > max_blossom_cost;
+    // The costs that a warm start gives to the pairs pruned in this call have to fit as well
+    auto const pruned_costs_fit = [&] {
+        return std::all_of(_last_pairs.begin(), _last_pairs.end(), [&](auto const& pair) {
+            return distances[pair_index(pair.first, pair.second)] != no_path
+                   or twice_pruning_threshold(pair.first, pair.second) / 2 + 1 <= max_blossom_cost;
+        });
+    };
+    bool const warm_start = not wide_costs and _options.warm_start and _last_matching and _last_odd_nodes == odd_nodes
+                            and pairs_are_subset_of_last() and pruned_costs_fit();
+    // Blossom V would truncate wide costs, and the previous matching cannot be updated with them either
+    std::optional<WidePerfectMatching> wide_solver;
+    {
+        MMC_INSTRUMENT_PHASE(matching_setup);
+        if (wide_costs) {
+            _last_matching.reset();
+            _last_odd_nodes.clear();
+            _last_pairs.clear();
+            _last_edge_costs.clear();
+            wide_solver.emplace(num_odd);
+            for (size_t lower = 0; lower < num_odd; ++lower) {
+                for (size_t higher = lower + 1; higher < num_odd; ++higher) {
+                    auto const distance = distances[pair_index(lower, higher)];
+                    if (distance != no_path) {
+                        wide_solver->add_edge(lower, higher, distance);
+                    }
+                }
+            }
+        } else if (warm_start) {
+            _last_matching->StartUpdate();
+            for (size_t edge_id = 0; edge_id < _last_pairs.size(); ++edge_id) {
+                auto const&[lower, higher] = _last_pairs[edge_id];
+                auto distance = distances[pair_index(lower, higher)];
+                if (distance == no_path) {
+                    // Pruned in this call. Any cost above the pruning threshold keeps the edge out of all minimum
+                    // matchings, as the bound only uses the true distances of the other pairs or such costs.
+                    assert(bounds);
+                    distance = twice_pruning_threshold(lower, higher) / 2 + 1;
+                }
+                auto const delta = distance - _last_edge_costs[edge_id];
+                if (delta != 0) {
+                    _last_matching->UpdateCost(static_cast<int>(edge_id), static_cast<PerfectMatching::REAL>(delta));
+                    _last_edge_costs[edge_id] = distance;
+                }
+            }
+            _last_matching->FinishUpdate();
+        } else {
+            _last_matching = std::make_unique<PerfectMatching>(
+                    static_cast<int>(num_odd), static_cast<int>(num_pairs)
+            );
+            _last_odd_nodes = odd_nodes;
+            _last_pairs.clear();
+            _last_edge_costs.clear();
+            for (size_t lower = 0; lower < num_odd; ++lower) {
+                for (size_t higher = lower + 1; higher < num_odd; ++higher) {
+                    auto const distance = distances[pair_index(lower, higher)];
+                    if (distance != no_path) {
+                        _last_matching->AddEdge(static_cast<int>(lower), static_cast<int>(higher), distance);
+                        _last_pairs.emplace_back(lower, higher);
+                        _last_edge_costs.push_back(distance);
+                    }
+                }
+            }
+        }
+    }
+    MMC_INSTRUMENT_COUNT(matching_edges, wide_solver ? num_pairs : _last_edge_costs.size());
+    {
+        MMC_INSTRUMENT_PHASE(matching_solve);
+        if (wide_solver) {
+            wide_solver->solve();
+        } else {
+            _last_matching->Solve();
+        }
+    }
+    std::chrono::duration<double> const solve_time = std::chrono::steady_clock::now() - start_time;
+    if (warm_start) {
+        ++_statistics.num_warm_solves;
+        _statistics.warm_solve_seconds += solve_time.count();
+    } else {
+        ++_statistics.num_cold_solves;
+        _statistics.cold_solve_seconds += solve_time.count();
+    }
+    MMC_INSTRUMENT_PHASE(join_extraction);
+    // Only the paths selected by the matching are needed. They are recomputed by running Dijkstra's algorithm from the
+    // lower end until the higher end is found, which is cheap since matched nodes tend to be close to each other.
+    std::vector<std::pair<size_t, size_t>> matched_pairs;
+    for (size_t odd_node_index = 0; odd_node_index < num_odd; ++odd_node_index) {
+        size_t const matched_to_index = wide_solver ? wide_solver->match(odd_node_index) :
+                                        _last_matching->GetMatch(static_cast<int>(odd_node_index));
+        if (matched_to_index > odd_node_index) {
+            matched_pairs.emplace_back(odd_node_index, matched_to_index);
+        }
+    }
+    std::vector<TJoin> thread_edges(num_threads);
+    parallel_for_dynamic(matched_pairs.size(), num_threads, [&](size_t const pair_id, unsigned const thread_index) {
+        auto const&[lower, higher] = matched_pairs[pair_id];
+        ShortestPathCalculator calc(
+                odd_nodes[lower], _base_graph, cost_transform, &_workspace.dijkstra[thread_index]
+        );
+        calc.run_until_found(odd_nodes.begin() + higher, odd_nodes.begin() + higher + 1);
+        calc.append_path_edges(odd_nodes[higher], thread_edges[thread_index]);
+    });
     // Collect the union of all selected paths
     TJoin result;
-    for (size_t odd_node_index = 0; odd_node_index < odd_nodes.size(); ++odd_node_index) {
-        size_t const matched_to_index = solver.GetMatch(odd_node_index);
-        if (matched_to_index < odd_node_index) {
-            auto const& path = paths.at(std::make_pair(matched_to_index, odd_node_index)).edge_set;
+    for (auto const& edges : thread_edges) {
+        std::copy(edges.begin(), edges.end(), std::back_inserter(result));
+    }
 #ifndef NDEBUG
-            for (auto const&[first, second] : path) {
-                assert(first < second);
-            }
+    for (auto const&[first, second] : result) {
+        assert(first < second);
+    }
 #endif
-            std::copy(path.begin(), path.end(), std::back_inserter(result));
+    remove_duplicate_pairs(result);
+    return result;
+}
+
+TJoin TJoinCalculator::get_minimum_cost_t_join_voronoi(
+        std::vector<NodeId> const& odd_nodes, Gamma const cost_transform
+) {
+    if (odd_nodes.empty()) {
+        return {};
+    }
+    auto const no_terminal = std::numeric_limits<size_t>::max();
+    std::vector<size_t> terminal_index(_base_graph.num_nodes(), no_terminal);
+    for (size_t i = 0; i < odd_nodes.size(); ++i) {
+        terminal_index[odd_nodes[i]] = i;
+    }
+    // Partition the graph into the Voronoi regions of the odd nodes
+    ShortestPathCalculator regions(odd_nodes, _base_graph, cost_transform, &_workspace.regions);
+    {
+        MMC_INSTRUMENT_PHASE(dijkstra);
+        regions.run_to_completion();
+    }
+    MMC_INSTRUMENT_START(setup_timer, matching_setup);
+
+    // Every edge connecting two regions gives a walk between the corresponding odd nodes. Its cost is an upper bound
+    // on their distance. Only the cheapest walk is kept for every pair of odd nodes.
+    auto const candidates = collect_region_candidates(_base_graph, regions, terminal_index, cost_transform);
+    auto const append_candidate_walk = [&](Candidate const& candidate, TJoin& edges) {
+        auto const& edge = _base_graph.edge(candidate.edge);
+        regions.append_path_edges(edge.first, edges);
+        edges.push_back(edge);
+        regions.append_path_edges(edge.second, edges);
+    };
+
+    // The candidate graph is connected in every connected component of the base graph, but it does not necessarily
+    // admit a perfect matching. To guarantee one, build a spanning forest of candidate edges and pair odd nodes that
+    // are consecutive in a preorder traversal. The walk along the tree path between them is an upper bound on their
+    // distance, and the total length of these paths is linear in the size of the forest.
+    auto const forest_edges = minimum_spanning_forest(candidates, odd_nodes.size());
+    struct TreeData {
+        size_t parent;
+        size_t parent_candidate;
+        size_t depth;
+    };
+    struct TreeWalk {
+        size_t first_end;
+        size_t second_end;
+        std::vector<size_t> candidate_ids;
+    };
+    std::vector<TreeData> tree_data(odd_nodes.size(), TreeData{no_terminal, no_terminal, 0});
+    std::vector<TreeWalk> tree_walks;
+    std::vector<size_t> stack;
+    for (size_t root = 0; root < odd_nodes.size(); ++root) {
+        if (tree_data[root].parent != no_terminal) {
+            continue;
+        }
+        tree_data[root].parent = root;
+        std::vector<size_t> preorder;
+        stack.push_back(root);
+        while (not stack.empty()) {
+            auto const current = stack.back();
+            stack.pop_back();
+            preorder.push_back(current);
+            for (auto const candidate_id : forest_edges[current]) {
+                auto const& candidate = candidates[candidate_id];
+                auto const next = candidate.lower == current ? candidate.higher : candidate.lower;
+                if (tree_data[next].parent == no_terminal) {
+                    tree_data[next] = TreeData{current, candidate_id, tree_data[current].depth + 1};
+                    stack.push_back(next);
+                }
+            }
+        }
+        // Every connected component contains an even number of odd nodes
+        assert(preorder.size() % 2 == 0);
+        for (size_t i = 0; i + 1 < preorder.size(); i += 2) {
+            auto a = preorder[i];
+            auto b = preorder[i + 1];
+            if (tree_data[b].parent == a) {
+                // Already present as a candidate edge
+                continue;
+            }
+            TreeWalk walk{a, b, {}};
+            while (a != b) {
+                auto& deeper = tree_data[a].depth >= tree_data[b].depth ? a : b;
+                walk.candidate_ids.push_back(tree_data[deeper].parent_candidate);
+                deeper = tree_data[deeper].parent;
+            }
+            tree_walks.push_back(std::move(walk));
         }
     }
-    // Remove pairs of duplicate edges
-    std::sort(result.begin(), result.end());
-    auto it = result.begin();
-    while (it != result.end() and it + 1 != result.end()) {
-        if (*it == *(it + 1)) {
-            it = result.erase(it, it + 2);
+
+    // Build the sparse matching instance. For every matching edge we remember how to build the corresponding walk.
+    enum class EdgeSource {
+        candidate,
+        tree_walk,
+        shortest_path,
+    };
+    std::vector<AccumulatedEdgeWeight> tree_walk_costs;
+    for (auto const& walk : tree_walks) {
+        AccumulatedEdgeWeight cost = 0;
+        for (auto const candidate_id : walk.candidate_ids) {
+            cost = std::min(cost + candidates[candidate_id].cost, max_blossom_cost + 1);
+        }
+        tree_walk_costs.push_back(cost);
+    }
+    auto const is_wide = [](AccumulatedEdgeWeight const cost) { return cost > max_blossom_cost; };
+    if (std::any_of(tree_walk_costs.begin(), tree_walk_costs.end(), is_wide)
+        or std::any_of(candidates.begin(), candidates.end(), [&](auto const& candidate) {
+            return is_wide(candidate.cost);
+        })) {
+        // Blossom V would truncate the costs. The pricing relies on its duals, so solve on all pairs with 64 bit costs.
+        MMC_INSTRUMENT_STOP(setup_timer);
+        return get_minimum_cost_t_join_all_pairs(odd_nodes, cost_transform);
+    }
+    std::vector<std::pair<EdgeSource, size_t>> edge_sources;
+    std::vector<TJoin> priced_paths;
+    PerfectMatching solver{
+            static_cast<int>(odd_nodes.size()), static_cast<int>(candidates.size() + tree_walks.size())
+    };
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        solver.AddEdge(candidates[i].lower, candidates[i].higher, candidates[i].cost);
+        edge_sources.emplace_back(EdgeSource::candidate, i);
+    }
+    for (size_t i = 0; i < tree_walks.size(); ++i) {
+        solver.AddEdge(tree_walks[i].first_end, tree_walks[i].second_end, tree_walk_costs[i]);
+        edge_sources.emplace_back(EdgeSource::tree_walk, i);
+    }
+    MMC_INSTRUMENT_STOP(setup_timer);
+    // Only the first solve is cold, the solves after a pricing round continue from the previous matching
+    auto const timed_solve = [this, &solver](bool const warm) {
+        MMC_INSTRUMENT_PHASE(matching_solve);
+        auto const start_time = std::chrono::steady_clock::now();
+        solver.Solve();
+        std::chrono::duration<double> const solve_time = std::chrono::steady_clock::now() - start_time;
+        if (warm) {
+            ++_statistics.num_warm_solves;
+            _statistics.warm_solve_seconds += solve_time.count();
         } else {
-            ++it;
+            ++_statistics.num_cold_solves;
+            _statistics.cold_solve_seconds += solve_time.count();
+        }
+    };
+    timed_solve(false);
+
+    // Pricing: the matching is optimal for the metric closure iff no pair of odd nodes violates the dual constraints.
+    // A pair (a, b) can only do so if 2 * dist(a, b) < twice_sum(a) + twice_sum(b), so a Dijkstra run from a can stop
+    // once twice the distance reaches twice_sum(a) + max_twice_sum.
+    std::vector<char> in_matching;
+    std::vector<PerfectMatching::REAL> twice_sum(odd_nodes.size());
+    while (true) {
+        MMC_INSTRUMENT_START(pricing_timer, dijkstra);
+        in_matching.resize(edge_sources.size());
+        for (size_t i = 0; i < edge_sources.size(); ++i) {
+            in_matching[i] = static_cast<char>(solver.GetSolution(static_cast<int>(i)));
+        }
+        solver.StartUpdate();
+        for (size_t i = 0; i < odd_nodes.size(); ++i) {
+            twice_sum[i] = solver.GetTwiceSum(static_cast<int>(i));
+        }
+        AccumulatedEdgeWeight const max_twice_sum = *std::max_element(twice_sum.begin(), twice_sum.end());
+        size_t num_added = 0;
+        for (size_t a = 0; a < odd_nodes.size(); ++a) {
+            AccumulatedEdgeWeight const twice_radius = twice_sum[a] + max_twice_sum;
+            if (twice_radius <= 0) {
+                continue;
+            }
+            ShortestPathCalculator calc(odd_nodes[a], _base_graph, cost_transform, &_workspace.dijkstra.front());
+            calc.run_up_to_distance((twice_radius - 1) / 2, [&](NodeId const node) {
+                auto const b = terminal_index[node];
+                if (b == no_terminal or b <= a) {
+                    return;
+                }
+                auto const distance = calc.distance(node);
+                if (2 * distance >= AccumulatedEdgeWeight{twice_sum[a]} + twice_sum[b]) {
+                    return;
+                }
+                auto const edge_id = solver.AddNewEdge(static_cast<int>(a), static_cast<int>(b), distance);
+                if (edge_id < 0) {
+                    return;
+                }
+                edge_sources.resize(std::max(edge_sources.size(), static_cast<size_t>(edge_id) + 1));
+                edge_sources[edge_id] = {EdgeSource::shortest_path, priced_paths.size()};
+                priced_paths.push_back(calc.make_path(node)->edge_set);
+                ++num_added;
+            });
+        }
+        solver.FinishUpdate();
+        if (num_added == 0) {
+            break;
+        }
+        MMC_INSTRUMENT_STOP(pricing_timer);
+        timed_solve(true);
+    }
+    MMC_INSTRUMENT_COUNT(matching_edges, edge_sources.size());
+    MMC_INSTRUMENT_PHASE(join_extraction);
+
+    // Collect the union of all selected walks
+    TJoin result;
+    for (size_t i = 0; i < in_matching.size(); ++i) {
+        if (not in_matching[i]) {
+            continue;
+        }
+        auto const&[source, index] = edge_sources[i];
+        switch (source) {
+            case EdgeSource::candidate:
+                append_candidate_walk(candidates[index], result);
+                break;
+            case EdgeSource::tree_walk:
+                for (auto const candidate_id : tree_walks[index].candidate_ids) {
+                    append_candidate_walk(candidates[candidate_id], result);
+                }
+                break;
+            case EdgeSource::shortest_path:
+                std::copy(priced_paths[index].begin(), priced_paths[index].end(), std::back_inserter(result));
+                break;
         }
     }
+    remove_duplicate_pairs(result);
     return result;
 }
 
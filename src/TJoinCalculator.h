@@ -2,27 +2,130 @@
 #define MINIMUMMEANCYCLE_TJOINCALCULATOR_H
 
 #include <functional>
+#include <memory>
 #include "graph.h"
-#include "MinimumMeanCycleCalculator.h"
+#include "Gamma.h"
+#include "ShortestPathCalculator.h"
+
+class PerfectMatching;
 
 namespace MMC {
 
 using TJoin = std::vector<Edge>;
 
+/// The algorithm used to compute minimum cost T-joins. Both produce T-joins of the same (minimum) cost.
+enum class TJoinStrategy {
+    /// Compute shortest paths between all pairs of odd nodes and match on the complete metric closure
+    all_pairs,
+    /**
+     * Match on a sparse instance: candidate edges are derived from the Voronoi regions of the odd nodes (one
+     * multi-source Dijkstra run). Missing pairs are priced in with the matching duals until no pair can improve the
+     * matching.
+     */
+    voronoi_pricing,
+};
+
+struct TJoinOptions {
+    TJoinStrategy strategy = TJoinStrategy::all_pairs;
+    /// Number of threads used for the shortest path computations, 0 means one per hardware thread
+    unsigned num_threads = 1;
+    /**
+     * Reuse the matching (including its duals) of the previous call if the set of odd nodes did not change, only
+     * updating the edge costs. Only supported for TJoinStrategy::all_pairs.
+     */
+    bool warm_start = true;
+    /**
+     * Skip pairs of odd nodes that cannot be matched in any minimum matching, which lets the shortest path searches of
+     * TJoinStrategy::all_pairs stop early. A pair (a, b) is skipped if
+     * 2 * dist(a, b) > 2 * upper_bound - sum(nearest) + nearest(a) + nearest(b),
+     * where nearest is the distance to the nearest other odd node and upper_bound the cost of a T-join in a spanning
+     * forest of the Voronoi regions of the odd nodes. The bound is global, so it mostly prunes pairs on graphs whose
+     * odd nodes form far apart clusters, and computing it costs about one extra Dijkstra run plus sorting the region
+     * boundary edges per call.
+     */
+    bool prune_pairs = false;
+};
+
+/// Timing information on the matching solves of a TJoinCalculator
+struct MatchingStatistics {
+    size_t num_cold_solves = 0;
+    size_t num_warm_solves = 0;
+    double cold_solve_seconds = 0;
+    double warm_solve_seconds = 0;
+
+    /**
+     * Estimates the time saved by warm starts, assuming a cold solve would have taken as long as the average cold solve
+     * performed. Negative if warm starts were slower.
+     */
+    [[nodiscard]] double estimated_seconds_saved() const;
+
+    MatchingStatistics& operator+=(MatchingStatistics const& other);
+};
+
+/**
+ * Buffers of a TJoinCalculator that can outlive it, so that solving many graphs (or the same graph with different
+ * weights) does not reallocate them. A workspace must not be used by two calculators at the same time.
+ */
+struct TJoinWorkspace {
+    /// One per thread
+    std::vector<DijkstraWorkspace> dijkstra;
+    /// Used for the Voronoi regions, which are needed while the other workspaces are in use
+    DijkstraWorkspace regions;
+    /// The pairwise distances of the all-pairs strategy
+    std::vector<AccumulatedEdgeWeight> distances;
+};
+
 class TJoinCalculator {
 public:
-    explicit TJoinCalculator(Graph const& baseGraph);
+    /// If no workspace is given, the calculator allocates its own
+    explicit TJoinCalculator(Graph const& baseGraph, TJoinOptions options = {}, TJoinWorkspace* workspace = nullptr);
+
+    ~TJoinCalculator();
 
-    /// Calculate a minimum \emptyset-join with cost function cost_transform.apply(-)
-    [[nodiscard]] TJoin get_minimum_zero_join(Gamma cost_transform) const;
+    /**
+     * Calculate a minimum \emptyset-join with cost function cost_transform.apply(-). Throws std::runtime_error if path
+     * costs under this transformation could overflow 64 bits.
+     */
+    [[nodiscard]] TJoin get_minimum_zero_join(Gamma cost_transform);
 
     /// Calculate a minimum (odd_nodes)-join with cost function abs(cost_transform.apply(-))
-    [[nodiscard]] TJoin get_minimum_cost_t_join_abs(std::vector<NodeId> const& odd_nodes, Gamma cost_transform) const;
+    [[nodiscard]] TJoin get_minimum_cost_t_join_abs(std::vector<NodeId> const& odd_nodes, Gamma cost_transform);
+
+    [[nodiscard]] MatchingStatistics const& matching_statistics() const;
 
 private:
+    [[nodiscard]] TJoin get_minimum_cost_t_join_all_pairs(std::vector<NodeId> const& odd_nodes, Gamma cost_transform);
+
+    [[nodiscard]] TJoin get_minimum_cost_t_join_voronoi(std::vector<NodeId> const& odd_nodes, Gamma cost_transform);
+
+    /// Throws if a walk through at most 2 n edges could cost more than half the largest AccumulatedEdgeWeight
+    void check_cost_range(Gamma cost_transform) const;
+
     Graph const& _base_graph;
+    TJoinOptions const _options;
+    /// The range of the edge weights and the largest length, which bound the transformed edge costs
+    EdgeWeight _min_weight = 0;
+    EdgeWeight _max_weight = 0;
+    EdgeLength _max_length = 1;
+    MatchingStatistics _statistics;
+    /// Only set if no workspace was passed to the constructor
+    std::unique_ptr<TJoinWorkspace> const _own_workspace;
+    TJoinWorkspace& _workspace;
+
+    /// The matching solved by the last call, kept for warm starts
+    std::unique_ptr<PerfectMatching> _last_matching;
+    /// The odd nodes of the last call, i.e. the nodes of _last_matching
+    std::vector<NodeId> _last_odd_nodes;
+    /// The ends (as indices in _last_odd_nodes) of every edge of _last_matching, indexed by edge ID
+    std::vector<std::pair<size_t, size_t>> _last_pairs;
+    /// Current cost of every edge of _last_matching, indexed by edge ID
+    std::vector<AccumulatedEdgeWeight> _last_edge_costs;
 };
 
+inline MatchingStatistics const& TJoinCalculator::matching_statistics() const {
+    return _statistics;
+}
+
 }
 
 #endif //MINIMUMMEANCYCLE_TJOINCALCULATOR_H
@@ -0,0 +1,547 @@
+#include "WidePerfectMatching.h" // always include corresponding header first
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace MMC {
+
+namespace {
+
+using Index = std::ptrdiff_t;
+
+/// Element of a cyclic list, index may be negative or exceed the size once
+Index cyclic_at(std::vector<Index> const& list, Index const index) {
+    auto const size = static_cast<Index>(list.size());
+    return list[static_cast<size_t>((index % size + size) % size)];
+}
+
+Index position_of(std::vector<Index> const& list, Index const element) {
+    auto const it = std::find(list.begin(), list.end(), element);
+    assert(it != list.end());
+    return it - list.begin();
+}
+
+} // end of anonymous namespace
+
+WidePerfectMatching::WidePerfectMatching(size_t const num_nodes) : _incident_ends(num_nodes) {}
+
+size_t WidePerfectMatching::add_edge(size_t const first, size_t const second, Cost const cost) {
+    if (cost < 0 or cost > max_cost) {
+        throw std::runtime_error("Matching cost out of range: " + std::to_string(cost));
+    }
+    assert(first != second and first < _incident_ends.size() and second < _incident_ends.size());
+    auto const edge = static_cast<Index>(_edges.size());
+    _edges.push_back(WeightedEdge{static_cast<Index>(first), static_cast<Index>(second), max_cost + 1 - cost});
+    _incident_ends[first].push_back(2 * edge + 1);
+    _incident_ends[second].push_back(2 * edge);
+    return static_cast<size_t>(edge);
+}
+
+size_t WidePerfectMatching::match(size_t const node) const {
+    assert(_mate[node] >= 0);
+    return static_cast<size_t>(endpoint(_mate[node]));
+}
+
+auto WidePerfectMatching::num_nodes() const -> Index {
+    return static_cast<Index>(_incident_ends.size());
+}
+
+auto WidePerfectMatching::endpoint(Index const end) const -> Index {
+    auto const& edge = _edges[static_cast<size_t>(end / 2)];
+    return end % 2 == 0 ? edge.first : edge.second;
+}
+
+auto WidePerfectMatching::slack(Index const edge) const -> Cost {
+    auto const& [first, second, weight] = _edges[static_cast<size_t>(edge)];
+    return _dual[first] + _dual[second] - 2 * weight;
+}
+
+template<class Function>
+void WidePerfectMatching::for_each_leaf(Index const blossom, Function const& function) const {
+    if (blossom < num_nodes()) {
+        function(blossom);
+        return;
+    }
+    for (auto const child : _blossom_children[blossom]) {
+        for_each_leaf(child, function);
+    }
+}
+
+void WidePerfectMatching::assign_label(Index const node, int const label, Index const end) {
+    auto const blossom = _in_blossom[node];
+    assert(_label[node] == 0 and _label[blossom] == 0);
+    _label[node] = _label[blossom] = label;
+    _label_end[node] = _label_end[blossom] = end;
+    _best_edge[node] = _best_edge[blossom] = -1;
+    if (label == 1) {
+        for_each_leaf(blossom, [this](Index const leaf) { _queue.push_back(leaf); });
+    } else {
+        // A T-blossom is entered by an unmatched edge, its base is matched to a node that becomes an S-node
+        auto const base = _blossom_base[blossom];
+        assert(_mate[base] >= 0);
+        assign_label(endpoint(_mate[base]), 1, _mate[base] ^ 1);
+    }
+}
+
+auto WidePerfectMatching::scan_blossom(Index node, Index other) -> Index {
+    // Walk up the alternating trees of both nodes in turns, marking the visited S-blossoms with label 5, until either a
+    // marked blossom (the common base) or both roots are reached
+    std::vector<Index> path;
+    Index base = -1;
+    while (node != -1 or other != -1) {
+        auto blossom = _in_blossom[node];
+        if (_label[blossom] & 4) {
+            base = _blossom_base[blossom];
+            break;
+        }
+        assert(_label[blossom] == 1);
+        path.push_back(blossom);
+        _label[blossom] = 5;
+        if (_label_end[blossom] == -1) {
+            node = -1;
+        } else {
+            node = endpoint(_label_end[blossom]);
+            blossom = _in_blossom[node];
+            assert(_label[blossom] == 2 and _label_end[blossom] >= 0);
+            node = endpoint(_label_end[blossom]);
+        }
+        if (other != -1) {
+            std::swap(node, other);
+        }
+    }
+    for (auto const blossom : path) {
+        _label[blossom] = 1;
+    }
+    return base;
+}
+
+void WidePerfectMatching::add_blossom(Index const base, Index const edge) {
+    auto node = _edges[edge].first;
+    auto other = _edges[edge].second;
+    auto const base_blossom = _in_blossom[base];
+    auto node_blossom = _in_blossom[node];
+    auto other_blossom = _in_blossom[other];
+    auto const blossom = _unused_blossoms.back();
+    _unused_blossoms.pop_back();
+    _blossom_base[blossom] = base;
+    _blossom_parent[blossom] = -1;
+    _blossom_parent[base_blossom] = blossom;
+    auto& children = _blossom_children[blossom];
+    auto& ends = _blossom_ends[blossom];
+    children.clear();
+    ends.clear();
+    // Trace back from node to the base, then from other to the base, to get the cycle of sub-blossoms in order
+    while (node_blossom != base_blossom) {
+        _blossom_parent[node_blossom] = blossom;
+        children.push_back(node_blossom);
+        ends.push_back(_label_end[node_blossom]);
+        assert(_label_end[node_blossom] >= 0);
+        node = endpoint(_label_end[node_blossom]);
+        node_blossom = _in_blossom[node];
+    }
+    children.push_back(base_blossom);
+    std::reverse(children.begin(), children.end());
+    std::reverse(ends.begin(), ends.end());
+    ends.push_back(2 * edge);
+    while (other_blossom != base_blossom) {
+        _blossom_parent[other_blossom] = blossom;
+        children.push_back(other_blossom);
+        ends.push_back(_label_end[other_blossom] ^ 1);
+        assert(_label_end[other_blossom] >= 0);
+        other = endpoint(_label_end[other_blossom]);
+        other_blossom = _in_blossom[other];
+    }
+    assert(_label[base_blossom] == 1);
+    _label[blossom] = 1;
+    _label_end[blossom] = _label_end[base_blossom];
+    _dual[blossom] = 0;
+    for_each_leaf(blossom, [&](Index const leaf) {
+        if (_label[_in_blossom[leaf]] == 2) {
+            // T-nodes become S-nodes inside the new blossom
+            _queue.push_back(leaf);
+        }
+        _in_blossom[leaf] = blossom;
+    });
+    // Compute the least-slack edges from the new blossom to the neighboring S-blossoms
+    std::vector<Index> best_edge_to(static_cast<size_t>(2 * num_nodes()), -1);
+    auto const consider = [&](Index const candidate) {
+        auto neighbor = _edges[candidate].second;
+        if (_in_blossom[neighbor] == blossom) {
+            neighbor = _edges[candidate].first;
+        }
+        auto const neighbor_blossom = _in_blossom[neighbor];
+        if (neighbor_blossom != blossom and _label[neighbor_blossom] == 1
+            and (best_edge_to[neighbor_blossom] == -1 or slack(candidate) < slack(best_edge_to[neighbor_blossom]))) {
+            best_edge_to[neighbor_blossom] = candidate;
+        }
+    };
+    for (auto const child : children) {
+        if (not _has_blossom_best_edges[child]) {
+            for_each_leaf(child, [&](Index const leaf) {
+                for (auto const end : _incident_ends[leaf]) {
+                    consider(end / 2);
+                }
+            });
+        } else {
+            for (auto const candidate : _blossom_best_edges[child]) {
+                consider(candidate);
+            }
+        }
+        _blossom_best_edges[child].clear();
+        _has_blossom_best_edges[child] = false;
+        _best_edge[child] = -1;
+    }
+    auto& best_edges = _blossom_best_edges[blossom];
+    best_edges.clear();
+    std::copy_if(best_edge_to.begin(), best_edge_to.end(), std::back_inserter(best_edges), [](Index const candidate) {
+        return candidate != -1;
+    });
+    _has_blossom_best_edges[blossom] = true;
+    _best_edge[blossom] = -1;
+    for (auto const candidate : best_edges) {
+        if (_best_edge[blossom] == -1 or slack(candidate) < slack(_best_edge[blossom])) {
+            _best_edge[blossom] = candidate;
+        }
+    }
+}
+
+void WidePerfectMatching::expand_blossom(Index const blossom, bool const end_of_stage) {
+    for (auto const child : _blossom_children[blossom]) {
+        _blossom_parent[child] = -1;
+        if (child < num_nodes()) {
+            _in_blossom[child] = child;
+        } else if (end_of_stage and _dual[child] == 0) {
+            expand_blossom(child, end_of_stage);
+        } else {
+            for_each_leaf(child, [&](Index const leaf) { _in_blossom[leaf] = child; });
+        }
+    }
+    if (not end_of_stage and _label[blossom] == 2) {
+        // Relabel the sub-blossoms on the even length path from the entry child to the base as T and S alternately
+        auto const& children = _blossom_children[blossom];
+        auto const& ends = _blossom_ends[blossom];
+        assert(_label_end[blossom] >= 0);
+        auto const entry_child = _in_blossom[endpoint(_label_end[blossom] ^ 1)];
+        auto position = position_of(children, entry_child);
+        Index step;
+        Index end_trick;
+        if (position & 1) {
+            position -= static_cast<Index>(children.size());
+            step = 1;
+            end_trick = 0;
+        } else {
+            step = -1;
+            end_trick = 1;
+        }
+        auto end = _label_end[blossom];
+        while (position != 0) {
+            _label[endpoint(end ^ 1)] = 0;
+            _label[endpoint(cyclic_at(ends, position - end_trick) ^ end_trick ^ 1)] = 0;
+            assign_label(endpoint(end ^ 1), 2, end);
+            _allowed_edge[cyclic_at(ends, position - end_trick) / 2] = true;
+            position += step;
+            end = cyclic_at(ends, position - end_trick) ^ end_trick;
+            _allowed_edge[end / 2] = true;
+            position += step;
+        }
+        auto child = cyclic_at(children, position);
+        _label[endpoint(end ^ 1)] = _label[child] = 2;
+        _label_end[endpoint(end ^ 1)] = _label_end[child] = end;
+        _best_edge[child] = -1;
+        position += step;
+        // The sub-blossoms on the other path become unlabeled, unless one of their nodes is reachable by a T-label
+        while (cyclic_at(children, position) != entry_child) {
+            child = cyclic_at(children, position);
+            if (_label[child] == 1) {
+                position += step;
+                continue;
+            }
+            Index labeled_leaf = -1;
+            for_each_leaf(child, [&](Index const leaf) {
+                if (labeled_leaf == -1 and _label[leaf] != 0) {
+                    labeled_leaf = leaf;
+                }
+            });
+            if (labeled_leaf != -1) {
+                assert(_label[labeled_leaf] == 2 and _in_blossom[labeled_leaf] == child);
+                _label[labeled_leaf] = 0;
+                _label[endpoint(_mate[_blossom_base[child]])] = 0;
+                assign_label(labeled_leaf, 2, _label_end[labeled_leaf]);
+            }
+            position += step;
+        }
+    }
+    _label[blossom] = -1;
+    _label_end[blossom] = -1;
+    _blossom_children[blossom].clear();
+    _blossom_ends[blossom].clear();
+    _blossom_base[blossom] = -1;
+    _blossom_best_edges[blossom].clear();
+    _has_blossom_best_edges[blossom] = false;
+    _best_edge[blossom] = -1;
+    _unused_blossoms.push_back(blossom);
+}
+
+void WidePerfectMatching::augment_blossom(Index const blossom, Index const node) {
+    // Swap matched and unmatched edges on the even length path from node to the base, which makes node the new base
+    auto child = node;
+    while (_blossom_parent[child] != blossom) {
+        child = _blossom_parent[child];
+    }
+    if (child >= num_nodes()) {
+        augment_blossom(child, node);
+    }
+    auto& children = _blossom_children[blossom];
+    auto& ends = _blossom_ends[blossom];
+    auto const start = position_of(children, child);
+    auto position = start;
+    Index step;
+    Index end_trick;
+    if (start & 1) {
+        position -= static_cast<Index>(children.size());
+        step = 1;
+        end_trick = 0;
+    } else {
+        step = -1;
+        end_trick = 1;
+    }
+    while (position != 0) {
+        position += step;
+        child = cyclic_at(children, position);
+        auto const end = cyclic_at(ends, position - end_trick) ^ end_trick;
+        if (child >= num_nodes()) {
+            augment_blossom(child, endpoint(end));
+        }
+        position += step;
+        child = cyclic_at(children, position);
+        if (child >= num_nodes()) {
+            augment_blossom(child, endpoint(end ^ 1));
+        }
+        _mate[endpoint(end)] = end ^ 1;
+        _mate[endpoint(end ^ 1)] = end;
+    }
+    std::rotate(children.begin(), children.begin() + start, children.end());
+    std::rotate(ends.begin(), ends.begin() + start, ends.end());
+    _blossom_base[blossom] = _blossom_base[children.front()];
+    assert(_blossom_base[blossom] == node);
+}
+
+void WidePerfectMatching::augment_matching(Index const edge) {
+    // Augment along the path through edge from the root of one alternating tree to the root of the other
+    for (auto [node, end] : {std::pair{_edges[edge].first, 2 * edge + 1}, std::pair{_edges[edge].second, 2 * edge}}) {
+        while (true) {
+            auto const node_blossom = _in_blossom[node];
+            assert(_label[node_blossom] == 1);
+            if (node_blossom >= num_nodes()) {
+                augment_blossom(node_blossom, node);
+            }
+            _mate[node] = end;
+            if (_label_end[node_blossom] == -1) {
+                // Reached the root
+                break;
+            }
+            auto const t_node = endpoint(_label_end[node_blossom]);
+            auto const t_blossom = _in_blossom[t_node];
+            assert(_label[t_blossom] == 2 and _label_end[t_blossom] >= 0);
+            node = endpoint(_label_end[t_blossom]);
+            auto const t_base = endpoint(_label_end[t_blossom] ^ 1);
+            assert(_blossom_base[t_blossom] == t_node);
+            if (t_blossom >= num_nodes()) {
+                augment_blossom(t_blossom, t_base);
+            }
+            _mate[t_base] = _label_end[t_blossom];
+            end = _label_end[t_blossom] ^ 1;
+        }
+    }
+}
+
+bool WidePerfectMatching::run_stage() {
+    auto const num_slots = static_cast<size_t>(2 * num_nodes());
+    _label.assign(num_slots, 0);
+    _best_edge.assign(num_slots, -1);
+    for (auto blossom = static_cast<size_t>(num_nodes()); blossom < num_slots; ++blossom) {
+        _blossom_best_edges[blossom].clear();
+        _has_blossom_best_edges[blossom] = false;
+    }
+    _allowed_edge.assign(_edges.size(), false);
+    _queue.clear();
+    for (Index node = 0; node < num_nodes(); ++node) {
+        if (_mate[node] == -1 and _label[_in_blossom[node]] == 0) {
+            assign_label(node, 1, -1);
+        }
+    }
+    while (true) {
+        // Grow the alternating trees along tight edges
+        while (not _queue.empty()) {
+            auto const node = _queue.back();
+            _queue.pop_back();
+            assert(_label[_in_blossom[node]] == 1);
+            for (auto const end : _incident_ends[node]) {
+                auto const edge = end / 2;
+                auto const other = endpoint(end);
+                if (_in_blossom[node] == _in_blossom[other]) {
+                    continue;
+                }
+                Cost edge_slack = 0;
+                if (not _allowed_edge[edge]) {
+                    edge_slack = slack(edge);
+                    if (edge_slack <= 0) {
+                        _allowed_edge[edge] = true;
+                    }
+                }
+                if (_allowed_edge[edge]) {
+                    if (_label[_in_blossom[other]] == 0) {
+                        assign_label(other, 2, end ^ 1);
+                    } else if (_label[_in_blossom[other]] == 1) {
+                        auto const base = scan_blossom(node, other);
+                        if (base >= 0) {
+                            add_blossom(base, edge);
+                        } else {
+                            augment_matching(edge);
+                            return true;
+                        }
+                    } else if (_label[other] == 0) {
+                        assert(_label[_in_blossom[other]] == 2);
+                        _label[other] = 2;
+                        _label_end[other] = end ^ 1;
+                    }
+                } else if (_label[_in_blossom[other]] == 1) {
+                    auto const blossom = _in_blossom[node];
+                    if (_best_edge[blossom] == -1 or edge_slack < slack(_best_edge[blossom])) {
+                        _best_edge[blossom] = edge;
+                    }
+                } else if (_label[other] == 0) {
+                    if (_best_edge[other] == -1 or edge_slack < slack(_best_edge[other])) {
+                        _best_edge[other] = edge;
+                    }
+                }
+            }
+        }
+
+        // No tight edge is left, so change the duals by the largest delta that keeps them feasible
+        enum class DeltaType { none, grow, close_blossom, expand_blossom };
+        auto delta_type = DeltaType::none;
+        Cost delta = 0;
+        Index delta_edge = -1;
+        Index delta_blossom = -1;
+        for (Index node = 0; node < num_nodes(); ++node) {
+            if (_label[_in_blossom[node]] == 0 and _best_edge[node] != -1) {
+                auto const candidate = slack(_best_edge[node]);
+                if (delta_type == DeltaType::none or candidate < delta) {
+                    delta = candidate;
+                    delta_type = DeltaType::grow;
+                    delta_edge = _best_edge[node];
+                }
+            }
+        }
+        for (Index blossom = 0; blossom < 2 * num_nodes(); ++blossom) {
+            if (_blossom_parent[blossom] == -1 and _label[blossom] == 1 and _best_edge[blossom] != -1) {
+                auto const edge_slack = slack(_best_edge[blossom]);
+                // Both ends are S-nodes, whose duals all have the same parity
+                assert(edge_slack % 2 == 0);
+                if (delta_type == DeltaType::none or edge_slack / 2 < delta) {
+                    delta = edge_slack / 2;
+                    delta_type = DeltaType::close_blossom;
+                    delta_edge = _best_edge[blossom];
+                }
+            }
+        }
+        for (Index blossom = num_nodes(); blossom < 2 * num_nodes(); ++blossom) {
+            if (_blossom_base[blossom] >= 0 and _blossom_parent[blossom] == -1 and _label[blossom] == 2
+                and (delta_type == DeltaType::none or _dual[blossom] < delta)) {
+                delta = _dual[blossom];
+                delta_type = DeltaType::expand_blossom;
+                delta_blossom = blossom;
+            }
+        }
+        if (delta_type == DeltaType::none) {
+            // No augmenting path exists, the matching has maximum cardinality
+            return false;
+        }
+        for (Index node = 0; node < num_nodes(); ++node) {
+            if (_label[_in_blossom[node]] == 1) {
+                _dual[node] -= delta;
+            } else if (_label[_in_blossom[node]] == 2) {
+                _dual[node] += delta;
+            }
+        }
+        for (Index blossom = num_nodes(); blossom < 2 * num_nodes(); ++blossom) {
+            if (_blossom_base[blossom] >= 0 and _blossom_parent[blossom] == -1) {
+                if (_label[blossom] == 1) {
+                    _dual[blossom] += delta;
+                } else if (_label[blossom] == 2) {
+                    _dual[blossom] -= delta;
+                }
+            }
+        }
+        switch (delta_type) {
+            case DeltaType::grow:
+            case DeltaType::close_blossom: {
+                _allowed_edge[delta_edge] = true;
+                auto node = _edges[delta_edge].first;
+                if (_label[_in_blossom[node]] != 1) {
+                    node = _edges[delta_edge].second;
+                }
+                assert(_label[_in_blossom[node]] == 1);
+                _queue.push_back(node);
+                break;
+            }
+            case DeltaType::expand_blossom:
+                expand_blossom(delta_blossom, false);
+                break;
+            case DeltaType::none:
+                break;
+        }
+    }
+}
+
+void WidePerfectMatching::solve() {
+    auto const num_slots = static_cast<size_t>(2 * num_nodes());
+    Cost max_weight = 0;
+    for (auto const& edge : _edges) {
+        max_weight = std::max(max_weight, edge.weight);
+    }
+    _mate.assign(static_cast<size_t>(num_nodes()), -1);
+    _label.assign(num_slots, 0);
+    _label_end.assign(num_slots, -1);
+    _in_blossom.resize(static_cast<size_t>(num_nodes()));
+    for (Index node = 0; node < num_nodes(); ++node) {
+        _in_blossom[node] = node;
+    }
+    _blossom_parent.assign(num_slots, -1);
+    _blossom_children.assign(num_slots, {});
+    _blossom_base.assign(num_slots, -1);
+    for (Index node = 0; node < num_nodes(); ++node) {
+        _blossom_base[node] = node;
+    }
+    _blossom_ends.assign(num_slots, {});
+    _best_edge.assign(num_slots, -1);
+    _blossom_best_edges.assign(num_slots, {});
+    _has_blossom_best_edges.assign(num_slots, false);
+    _unused_blossoms.clear();
+    for (auto blossom = static_cast<Index>(num_slots); blossom-- > num_nodes();) {
+        _unused_blossoms.push_back(blossom);
+    }
+    _dual.assign(num_slots, 0);
+    std::fill(_dual.begin(), _dual.begin() + num_nodes(), max_weight);
+
+    // Every stage augments the matching by one edge
+    for (Index stage = 0; stage < num_nodes(); ++stage) {
+        if (not run_stage()) {
+            break;
+        }
+        // Expand the S-blossoms with zero dual, which cannot be expanded during a stage
+        for (Index blossom = num_nodes(); blossom < 2 * num_nodes(); ++blossom) {
+            if (_blossom_parent[blossom] == -1 and _blossom_base[blossom] >= 0 and _label[blossom] == 1
+                and _dual[blossom] == 0) {
+                expand_blossom(blossom, true);
+            }
+        }
+    }
+    if (std::count(_mate.begin(), _mate.end(), -1) > 0) {
+        throw std::runtime_error("The matching instance has no perfect matching");
+    }
+}
+
+}
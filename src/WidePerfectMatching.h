@@ -0,0 +1,94 @@
+#ifndef MINIMUMMEANCYCLE_WIDEPERFECTMATCHING_H
+#define MINIMUMMEANCYCLE_WIDEPERFECTMATCHING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace MMC {
+
+/**
+ * Minimum cost perfect matching in a general graph with 64 bit integer costs, using the O(n³) primal-dual blossom
+ * algorithm of Edmonds with the bookkeeping of Galil ("Efficient algorithms for finding maximum matching in graphs",
+ * 1986). Much slower than Blossom V on large instances, but exact for costs that do not fit into the int costs Blossom
+ * V is compiled with. All duals stay integral, so no rounding is involved.
+ */
+class WidePerfectMatching {
+public:
+    using Cost = int64_t;
+
+    /// Costs must be in [0, max_cost], so that no intermediate value of the algorithm overflows
+    static constexpr Cost max_cost = std::numeric_limits<Cost>::max() / 8;
+
+    explicit WidePerfectMatching(size_t num_nodes);
+
+    /// Adds an edge and returns its ID, the edges are numbered consecutively from 0
+    size_t add_edge(size_t first, size_t second, Cost cost);
+
+    /// Computes a minimum cost perfect matching, throws std::runtime_error if the graph has no perfect matching
+    void solve();
+
+    /// The node matched to node, only valid after solve()
+    [[nodiscard]] size_t match(size_t node) const;
+
+private:
+    using Index = std::ptrdiff_t;
+
+    struct WeightedEdge {
+        Index first;
+        Index second;
+        /// max_cost + 1 - cost, so that a maximum weight matching of maximum cardinality has minimum cost
+        Cost weight;
+    };
+
+    [[nodiscard]] Index num_nodes() const;
+
+    [[nodiscard]] Index endpoint(Index end) const;
+
+    [[nodiscard]] Cost slack(Index edge) const;
+
+    /// Calls function for every node contained in blossom (or for blossom itself if it is a node)
+    template<class Function>
+    void for_each_leaf(Index blossom, Function const& function) const;
+
+    void assign_label(Index node, int label, Index end);
+
+    /// Returns the base of the blossom closed by an edge between node and other, or -1 if they are in different trees
+    Index scan_blossom(Index node, Index other);
+
+    void add_blossom(Index base, Index edge);
+
+    void expand_blossom(Index blossom, bool end_of_stage);
+
+    void augment_blossom(Index blossom, Index node);
+
+    void augment_matching(Index edge);
+
+    /// Runs one stage, returns false if no augmenting path exists
+    bool run_stage();
+
+    std::vector<WeightedEdge> _edges;
+    std::vector<std::vector<Index>> _incident_ends;
+    // The state of the algorithm, in the notation of Galil. Indices below num_nodes() are nodes, the others blossoms.
+    // Edge ends are encoded as 2 * edge + (0 for the first or 1 for the second node).
+    std::vector<Index> _mate;
+    std::vector<int> _label;
+    std::vector<Index> _label_end;
+    std::vector<Index> _in_blossom;
+    std::vector<Index> _blossom_parent;
+    std::vector<std::vector<Index>> _blossom_children;
+    std::vector<Index> _blossom_base;
+    std::vector<std::vector<Index>> _blossom_ends;
+    std::vector<Index> _best_edge;
+    std::vector<std::vector<Index>> _blossom_best_edges;
+    std::vector<char> _has_blossom_best_edges;
+    std::vector<Index> _unused_blossoms;
+    std::vector<Cost> _dual;
+    std::vector<char> _allowed_edge;
+    std::vector<Index> _queue;
+};
+
+}
+
+#endif //MINIMUMMEANCYCLE_WIDEPERFECTMATCHING_H
@@ -1,28 +1,97 @@
 #include "graph.h" // always include corresponding header first
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <numeric>
 #include <stdexcept>
+#include <type_traits>
+#include "DimacsParser.h"
+#include "MappedFile.h"
 
 namespace MMC {
 
 namespace {
 
-NodeId from_dimacs_id(size_type dimacs_node_id) {
-    if (dimacs_node_id <= 0) {
-        throw std::runtime_error("Non-positive DIMACS node id can not be converted.");
-    }
-    return NodeId(dimacs_node_id - 1);
+constexpr char binary_graph_magic[8] = {'M', 'M', 'C', 'G', 'R', 'A', 'P', 'H'};
+constexpr uint32_t binary_graph_version = 1;
+/// Stored in native byte order, reads back differently on a machine with other endianness
+constexpr uint32_t binary_graph_byte_order_mark = 0x01020304;
+
+/**
+ * Header of the binary graph format. It is followed by the sections (in this order, without padding):
+ * offsets (num_nodes + 1 size_t), edges (num_edges pairs of uint32), edge weights (num_edges int32) and incidences
+ * (2 * num_edges triples of uint32/int32/uint32). This is exactly the in-memory representation of Graph, so loading
+ * is a copy of the mapped file.
+ */
+struct BinaryGraphHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint32_t num_nodes;
+    uint32_t reserved;
+    uint64_t num_edges;
+    /// Checksum of all sections, see checksum_of
+    uint64_t checksum;
+};
+static_assert(sizeof(BinaryGraphHeader) == 40, "The binary graph header must not contain padding");
+static_assert(sizeof(Incidence) == 12 and sizeof(Edge) == 8 and sizeof(size_t) == 8,
+              "Unexpected layout of the binary graph sections");
+
+/// A section of the binary graph format
+struct BinarySection {
+    char const* data;
+    size_t size;
+};
+
+std::array<BinarySection, 4> binary_sections(
+        void const* offsets, void const* edges, void const* weights, void const* incidences,
+        size_t const num_nodes, size_t const num_edges
+) {
+    return {{
+            {static_cast<char const*>(offsets), (num_nodes + 1) * sizeof(size_t)},
+            {static_cast<char const*>(edges), num_edges * sizeof(Edge)},
+            {static_cast<char const*>(weights), num_edges * sizeof(EdgeWeight)},
+            {static_cast<char const*>(incidences), 2 * num_edges * sizeof(Incidence)},
+    }};
 }
 
-// Returns the first line which is not a comment, i.e. does not start with c.
-std::string read_next_non_comment_line(std::istream& input) {
-    std::string line;
-    do {
-        if (!std::getline(input, line)) {
-            throw std::runtime_error("Unexpected end of DIMACS stream.");
+/**
+ * 64 bit checksum of the concatenated sections. Mixes one 64 bit word per multiplication and uses four independent
+ * lanes, so it runs at close to memory bandwidth. Not cryptographic, it only detects corrupt or truncated files.
+ */
+uint64_t checksum_of(std::array<BinarySection, 4> const& sections) {
+    constexpr uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    std::array<uint64_t, 4> lanes{1, 2, 3, 4};
+    auto const mix = [](uint64_t const hash, uint64_t const word) {
+        auto const mixed = (hash ^ word) * multiplier;
+        return mixed ^ (mixed >> 29);
+    };
+    for (auto const& section : sections) {
+        size_t position = 0;
+        for (; position + 4 * sizeof(uint64_t) <= section.size; position += 4 * sizeof(uint64_t)) {
+            for (size_t lane = 0; lane < 4; ++lane) {
+                uint64_t word{};
+                std::memcpy(&word, section.data + position + lane * sizeof(uint64_t), sizeof(word));
+                lanes[lane] = mix(lanes[lane], word);
+            }
+        }
+        for (; position < section.size; ++position) {
+            lanes[0] = mix(lanes[0], static_cast<unsigned char>(section.data[position]));
         }
-    } while (line[0] == 'c');
-    return line;
+        // Separate the sections, so moving data between them changes the checksum
+        lanes[0] = mix(lanes[0], section.size);
+    }
+    uint64_t result = 0;
+    for (auto const lane : lanes) {
+        result = mix(result, lane);
+    }
+    return result;
+}
+
+bool is_binary_graph(char const* const data, size_t const size) {
+    return size >= sizeof(BinaryGraphHeader) and std::memcmp(data, binary_graph_magic, sizeof(binary_graph_magic)) == 0;
 }
 
 } // end of anonymous namespace
@@ -31,59 +100,346 @@ std::string read_next_non_comment_line(std::istream& input) {
 //! \c Graph definitions
 /////////////////////////////////////////////
 
-Graph::Graph(NodeId const num_nodes) :
-        _edge_costs(num_nodes * num_nodes),
-        _edge_in_graph(num_nodes * num_nodes),
-        _num_nodes(num_nodes) {}
+Graph::Graph(
+        NodeId const num_nodes, std::vector<Edge> edges, std::vector<EdgeWeight> const& weights,
+        GraphStorage const storage, std::vector<EdgeLength> const& lengths
+) : _num_nodes(num_nodes),
+    _storage(storage) {
+    assert(edges.size() == weights.size());
+    assert(lengths.empty() or lengths.size() == edges.size());
+    if (not lengths.empty() and storage != GraphStorage::sparse) {
+        throw std::runtime_error("Edge lengths are only supported with sparse storage!");
+    }
+    for (auto& edge : edges) {
+        if (edge.first == edge.second) {
+            throw std::runtime_error("MMC::Graph class does not support loops!");
+        }
+        if (edge.first >= num_nodes or edge.second >= num_nodes) {
+            throw std::runtime_error("Edge end is not a node of the graph!");
+        }
+        if (edge.first > edge.second) {
+            std::swap(edge.first, edge.second);
+        }
+    }
+    // Sort the edges lexicographically, this makes parallel edges adjacent and the adjacency lists built below sorted
+    std::vector<EdgeIndex> order(edges.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&edges](EdgeIndex const a, EdgeIndex const b) {
+        return edges[a] < edges[b];
+    });
+    _edges.reserve(edges.size());
+    _edge_weights.reserve(edges.size());
+    for (auto const index : order) {
+        if (not _edges.empty() and _edges.back() == edges[index]) {
+            throw std::runtime_error("MMC::Graph class does not support parallel edges!");
+        }
+        _edges.push_back(edges[index]);
+        _edge_weights.push_back(weights[index]);
+    }
+    if (std::any_of(lengths.begin(), lengths.end(), [](EdgeLength const length) { return length != 1; })) {
+        if (std::find(lengths.begin(), lengths.end(), EdgeLength{0}) != lengths.end()) {
+            throw std::runtime_error("Edge lengths must be positive!");
+        }
+        _edge_lengths.reserve(edges.size());
+        for (auto const index : order) {
+            _edge_lengths.push_back(lengths[index]);
+        }
+    }
+    if (_storage == GraphStorage::compact_dense) {
+        // The matrix replaces the adjacency lists
+        build_adjacency_matrix();
+        return;
+    }
+    // Build the adjacency lists. The edge with lower end x and higher end y appears in the list of y after all edges
+    // to lower ends and before all edges to higher ends, so the lists end up sorted by neighbor ID.
+    _offsets.assign(static_cast<size_t>(num_nodes) + 1, 0);
+    for (auto const&[lower, higher] : _edges) {
+        ++_offsets[lower + 1];
+        ++_offsets[higher + 1];
+    }
+    std::partial_sum(_offsets.begin(), _offsets.end(), _offsets.begin());
+    _incidences.resize(2 * _edges.size());
+    std::vector<size_t> next_free(_offsets.begin(), _offsets.end() - 1);
+    for (EdgeIndex i = 0; i < _edges.size(); ++i) {
+        auto const&[lower, higher] = _edges[i];
+        _incidences[next_free[lower]++] = Incidence{higher, _edge_weights[i], i};
+        _incidences[next_free[higher]++] = Incidence{lower, _edge_weights[i], i};
+    }
+    if (_storage != GraphStorage::sparse) {
+        build_adjacency_matrix();
+    }
+}
+
+Graph::Graph(NodeId const num_nodes, GraphStorage const storage) : _num_nodes(num_nodes), _storage(storage) {}
+
+void Graph::build_adjacency_matrix() {
+    if (_storage == GraphStorage::compact_dense) {
+        std::vector<size_t>().swap(_offsets);
+        std::vector<Incidence>().swap(_incidences);
+        _first_edge.assign(static_cast<size_t>(_num_nodes) + 1, 0);
+        for (auto const& edge : _edges) {
+            ++_first_edge[edge.first + 1];
+        }
+        std::partial_sum(_first_edge.begin(), _first_edge.end(), _first_edge.begin());
+        auto const num_entries = static_cast<size_t>(_num_nodes) * _num_nodes;
+        auto const fits_narrow = [](EdgeWeight const weight) {
+            return weight > std::numeric_limits<int16_t>::min() and weight <= std::numeric_limits<int16_t>::max();
+        };
+        auto const fill = [this, num_entries](auto& matrix) {
+            using Weight = typename std::remove_reference_t<decltype(matrix)>::value_type;
+            matrix.assign(num_entries, std::numeric_limits<Weight>::min());
+            for (EdgeIndex i = 0; i < _edges.size(); ++i) {
+                auto const& edge = _edges[i];
+                matrix[matrix_index(edge)] = static_cast<Weight>(_edge_weights[i]);
+                matrix[matrix_index({edge.second, edge.first})] = static_cast<Weight>(_edge_weights[i]);
+            }
+        };
+        // Only one matrix is kept, the memory of the other one is released
+        if (std::all_of(_edge_weights.begin(), _edge_weights.end(), fits_narrow)) {
+            std::vector<int32_t>().swap(_compact_matrix32);
+            fill(_compact_matrix16);
+        } else {
+            if (std::find(_edge_weights.begin(), _edge_weights.end(), std::numeric_limits<int32_t>::min())
+                != _edge_weights.end()) {
+                throw std::runtime_error("The weight -2^31 is reserved for missing edges in compact dense storage!");
+            }
+            std::vector<int16_t>().swap(_compact_matrix16);
+            fill(_compact_matrix32);
+        }
+        return;
+    }
+    _edge_costs.resize(static_cast<size_t>(_num_nodes) * _num_nodes);
+    _edge_in_graph.resize(static_cast<size_t>(_num_nodes) * _num_nodes);
+    for (EdgeIndex i = 0; i < _edges.size(); ++i) {
+        auto const& edge = _edges[i];
+        for (auto const& e : {edge, std::make_pair(edge.second, edge.first)}) {
+            _edge_in_graph[matrix_index(e)] = true;
+            _edge_costs[matrix_index(e)] = _edge_weights[i];
+        }
+    }
+}
 
-void Graph::add_edge(Edge const to_add, EdgeWeight const weight) {
-    if (to_add.first == to_add.second) {
-        throw std::runtime_error("MMC::Graph class does not support loops!");
+void Graph::set_edge_weights(std::vector<EdgeWeight> const& weights) {
+    if (weights.size() != _edges.size()) {
+        throw std::runtime_error("Number of weights does not match the number of edges!");
     }
-    if (edge_exists(to_add)) {
-        throw std::runtime_error("MMC::Graph class does not support parallel edges!");
+    std::copy(weights.begin(), weights.end(), _edge_weights.begin());
+    for (auto& incidence : _incidences) {
+        incidence.weight = _edge_weights[incidence.edge];
     }
-    for (auto const& e : {to_add, std::make_pair(to_add.second, to_add.first)}) {
-        _edge_in_graph.at(edge_id(e)) = true;
-        _edge_costs.at(edge_id(e)) = weight;
+    if (_storage == GraphStorage::dense) {
+        for (EdgeIndex i = 0; i < _edges.size(); ++i) {
+            auto const& edge = _edges[i];
+            _edge_costs[matrix_index(edge)] = _edge_weights[i];
+            _edge_costs[matrix_index({edge.second, edge.first})] = _edge_weights[i];
+        }
+    } else if (_storage == GraphStorage::compact_dense) {
+        // Rebuilding chooses the weight type again, which is only necessary if the new weights do not fit
+        build_adjacency_matrix();
     }
 }
 
-Graph Graph::read_dimacs(std::istream& input) {
-    std::string unused_word{};
-    std::string const first_line = read_next_non_comment_line(input);
+void Graph::set_edge_weight(EdgeIndex const index, EdgeWeight const weight) {
+    if (index >= _edges.size()) {
+        throw std::runtime_error("Edge index out of range!");
+    }
+    auto const& edge = _edges[index];
+    if (_storage == GraphStorage::compact_dense and weight == std::numeric_limits<int32_t>::min()) {
+        throw std::runtime_error("The weight -2^31 is reserved for missing edges in compact dense storage!");
+    }
+    _edge_weights[index] = weight;
+    if (_storage == GraphStorage::compact_dense) {
+        Edge const reverse{edge.second, edge.first};
+        if (not narrow_matrix()) {
+            _compact_matrix32[matrix_index(edge)] = weight;
+            _compact_matrix32[matrix_index(reverse)] = weight;
+        } else if (weight > std::numeric_limits<int16_t>::min() and weight <= std::numeric_limits<int16_t>::max()) {
+            _compact_matrix16[matrix_index(edge)] = static_cast<int16_t>(weight);
+            _compact_matrix16[matrix_index(reverse)] = static_cast<int16_t>(weight);
+        } else {
+            build_adjacency_matrix();
+        }
+        return;
+    }
+    for (auto const& end_to_end : {edge, std::make_pair(edge.second, edge.first)}) {
+        _incidences[find_incidence(end_to_end) - _incidences.data()].weight = weight;
+    }
+    if (_storage == GraphStorage::dense) {
+        _edge_costs[matrix_index(edge)] = weight;
+        _edge_costs[matrix_index({edge.second, edge.first})] = weight;
+    }
+}
+
+Incidence const* Graph::find_incidence(Edge const& edge) const {
+    auto const range = neighbors(edge.first);
+    auto const it = std::lower_bound(
+            range.begin(), range.end(), edge.second,
+            [](Incidence const& incidence, NodeId const node) { return incidence.neighbor < node; }
+    );
+    if (it == range.end() or it->neighbor != edge.second) {
+        return nullptr;
+    }
+    return it;
+}
+
+EdgeIndex Graph::find_edge_index(Edge const& edge) const {
+    assert(edge_exists(edge));
+    auto const&[lower, higher] = std::minmax(edge.first, edge.second);
+    auto const begin = _edges.begin() + _first_edge[lower];
+    auto const end = _edges.begin() + _first_edge[lower + 1];
+    auto const it = std::lower_bound(begin, end, higher, [](Edge const& candidate, NodeId const node) {
+        return candidate.second < node;
+    });
+    return static_cast<EdgeIndex>(it - _edges.begin());
+}
+
+Graph Graph::read_dimacs(std::istream& input, GraphStorage const storage) {
+    auto lines = read_dimacs_lines(input);
+    return Graph(lines.num_nodes, std::move(lines.edges), lines.weights, storage);
+}
+
+Graph Graph::read_dimacs_file(std::string const& path, GraphStorage const storage, unsigned const num_threads) {
+    MappedFile const file(path);
+    return parse_dimacs(file.data(), file.data() + file.size(), storage, num_threads);
+}
+
+Graph Graph::read_file(std::string const& path, GraphStorage const storage, unsigned const num_threads) {
+    MappedFile const file(path);
+    if (is_binary_graph(file.data(), file.size())) {
+        return parse_binary(file.data(), file.size(), storage, true);
+    }
+    return parse_dimacs(file.data(), file.data() + file.size(), storage, num_threads);
+}
+
+Graph Graph::parse_dimacs(
+        char const* const begin, char const* const end, GraphStorage const storage, unsigned const num_threads
+) {
+    auto lines = parse_dimacs_lines(begin, end, 'e', num_threads);
+    return Graph(lines.num_nodes, std::move(lines.edges), lines.weights, storage);
+}
+
+void Graph::write_dimacs(std::ostream& output) const {
+    if (has_edge_lengths()) {
+        throw std::runtime_error("The DIMACS format does not support edge lengths.");
+    }
+    output << "p edge " << _num_nodes << ' ' << _edges.size() << '\n';
+    for (EdgeIndex i = 0; i < _edges.size(); ++i) {
+        output << "e " << _edges[i].first + 1 << ' ' << _edges[i].second + 1 << ' ' << _edge_weights[i] << '\n';
+    }
+}
 
-    if (first_line[0] != 'p') {
-        throw std::runtime_error("Unexpected format of input file!");
+void Graph::write_binary_file(std::string const& path) const {
+    if (has_edge_lengths()) {
+        throw std::runtime_error("The binary format does not support edge lengths.");
     }
+    if (_storage == GraphStorage::compact_dense) {
+        // The format contains the adjacency lists, which this storage does not keep
+        Graph(_num_nodes, _edges, _edge_weights).write_binary_file(path);
+        return;
+    }
+    BinaryGraphHeader header{};
+    std::memcpy(header.magic, binary_graph_magic, sizeof(header.magic));
+    header.version = binary_graph_version;
+    header.byte_order_mark = binary_graph_byte_order_mark;
+    header.num_nodes = _num_nodes;
+    header.num_edges = _edges.size();
+    auto const sections = binary_sections(
+            _offsets.data(), _edges.data(), _edge_weights.data(), _incidences.data(), _num_nodes, _edges.size()
+    );
+    header.checksum = checksum_of(sections);
 
-    size_type num_nodes{};
-    size_type num_edges{};
-    std::stringstream first_buffering_stream{first_line};
-    first_buffering_stream >> unused_word >> unused_word >> num_nodes >> num_edges;
-    if (not first_buffering_stream) {
-        throw std::runtime_error("Invalid first line in DIMACS: " + first_line);
+    std::ofstream output(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (not output) {
+        throw std::runtime_error("Failed to open " + path + " for writing.");
+    }
+    output.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    for (auto const& section : sections) {
+        output.write(section.data, static_cast<std::streamsize>(section.size));
     }
+    output.flush();
+    if (not output) {
+        throw std::runtime_error("Failed to write " + path + ".");
+    }
+}
+
+Graph Graph::read_binary_file(std::string const& path, GraphStorage const storage, bool const verify_checksum) {
+    MappedFile const file(path);
+    return parse_binary(file.data(), file.size(), storage, verify_checksum);
+}
 
-    // Now we successively add edges to our result_graph;
-    Graph result_graph(NodeId{num_nodes});
-    for (size_type i = 1; i <= num_edges; ++i) {
-        std::string const ith_line = read_next_non_comment_line(input);
-        size_type dimacs_node1{};
-        size_type dimacs_node2{};
-        EdgeWeight weight{};
-        std::stringstream ith_buffering_stream{ith_line};
-        ith_buffering_stream >> unused_word >> dimacs_node1 >> dimacs_node2 >> weight;
-        if (not ith_buffering_stream or
-            dimacs_node1 < 1 or dimacs_node1 > num_nodes or
-            dimacs_node2 < 1 or dimacs_node2 > num_nodes) {
-            throw std::runtime_error("Invalid data in DIMACS line: " + ith_line);
+Graph Graph::parse_binary(char const* const data, size_t const size, GraphStorage const storage,
+                          bool const verify_checksum) {
+    if (not is_binary_graph(data, size)) {
+        throw std::runtime_error("Not a binary graph file.");
+    }
+    BinaryGraphHeader header{};
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != binary_graph_version) {
+        throw std::runtime_error("Unsupported binary graph version " + std::to_string(header.version) + ".");
+    }
+    if (header.byte_order_mark != binary_graph_byte_order_mark) {
+        throw std::runtime_error("Binary graph file was written on a machine with different byte order.");
+    }
+    if (header.num_edges > std::numeric_limits<EdgeIndex>::max()) {
+        throw std::runtime_error("Binary graph file has too many edges.");
+    }
+    auto const expected_size = sizeof(header) + (size_t{header.num_nodes} + 1) * sizeof(size_t) +
+                               header.num_edges * (sizeof(Edge) + sizeof(EdgeWeight) + 2 * sizeof(Incidence));
+    if (size != expected_size) {
+        throw std::runtime_error("Binary graph file is truncated or has trailing data.");
+    }
+    Graph graph(header.num_nodes, storage);
+    char const* position = data + sizeof(header);
+    auto const read_section = [&position](auto& vector, size_t const num_elements) {
+        vector.resize(num_elements);
+        auto const num_bytes = num_elements * sizeof(vector[0]);
+        std::memcpy(static_cast<void*>(vector.data()), position, num_bytes);
+        position += num_bytes;
+    };
+    read_section(graph._offsets, size_t{header.num_nodes} + 1);
+    read_section(graph._edges, header.num_edges);
+    read_section(graph._edge_weights, header.num_edges);
+    read_section(graph._incidences, 2 * header.num_edges);
+    auto const sections = binary_sections(
+            graph._offsets.data(), graph._edges.data(), graph._edge_weights.data(), graph._incidences.data(),
+            header.num_nodes, header.num_edges
+    );
+    if (verify_checksum and checksum_of(sections) != header.checksum) {
+        throw std::runtime_error("Checksum mismatch in binary graph file.");
+    }
+    // The checksum only detects accidental corruption and may be skipped, so check everything that is used for
+    // indexing later
+    auto const num_nodes = graph._num_nodes;
+    auto const num_edges = graph._edges.size();
+    if (std::any_of(graph._edges.begin(), graph._edges.end(), [num_nodes](Edge const& edge) {
+        return edge.first >= edge.second or edge.second >= num_nodes;
+    }) or not std::is_sorted(graph._edges.begin(), graph._edges.end())) {
+        throw std::runtime_error("Inconsistent edges in binary graph file.");
+    }
+    if (graph._offsets.front() != 0 or graph._offsets.back() != graph._incidences.size()
+        or not std::is_sorted(graph._offsets.begin(), graph._offsets.end())) {
+        throw std::runtime_error("Inconsistent adjacency lists in binary graph file.");
+    }
+    // Every incidence has to match its edge and the list of every node has to be strictly sorted by neighbor. Since the
+    // lists hold 2 m incidences, this also means that every edge is in the lists of both its ends exactly once.
+    for (NodeId node = 0; node < num_nodes; ++node) {
+        // Not graph.neighbors(node), which the requested storage may not support
+        ArrayRange<Incidence> const neighbors(
+                graph._incidences.data() + graph._offsets[node], graph._incidences.data() + graph._offsets[node + 1]
+        );
+        for (auto it = neighbors.begin(); it != neighbors.end(); ++it) {
+            if (it->neighbor >= num_nodes or it->edge >= num_edges
+                or (it != neighbors.begin() and it->neighbor <= (it - 1)->neighbor)
+                or graph._edges[it->edge] != Edge{std::min(node, it->neighbor), std::max(node, it->neighbor)}
+                or graph._edge_weights[it->edge] != it->weight) {
+                throw std::runtime_error("Inconsistent adjacency lists in binary graph file.");
+            }
         }
-        auto const node1 = from_dimacs_id(dimacs_node1);
-        auto const node2 = from_dimacs_id(dimacs_node2);
-        result_graph.add_edge({node1, node2}, weight);
     }
-    return result_graph;
+    if (storage != GraphStorage::sparse) {
+        graph.build_adjacency_matrix();
+    }
+    return graph;
 }
 
 } // namespace MMC
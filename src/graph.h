@@ -6,11 +6,14 @@
 
    @brief This file provides a simple class @c Graph to model unweighted undirected graphs.
 **/
+#include <algorithm>
 #include <iosfwd>
 #include <cstdint>
+#include <string>
 #include <limits>
 #include <vector>
 #include <functional>
+#include <iterator>
 #include <cassert>
 
 namespace MMC {
@@ -19,75 +22,466 @@ using size_type = uint32_t;
 
 using NodeId = size_type;
 
+using EdgeIndex = size_type;
+
 using EdgeWeight = int32_t;
 
 using AccumulatedEdgeWeight = int64_t;
 
+/// Number of edges of the original graph an edge stands for, see reduce_graph
+using EdgeLength = uint32_t;
+
 using Edge = std::pair<NodeId, NodeId>;
 
+/// One entry of the adjacency list of a node
+struct Incidence {
+    /// The other end of the edge
+    NodeId neighbor;
+    EdgeWeight weight;
+    /// Index of the edge in the (sorted) edge list of the graph
+    EdgeIndex edge;
+};
+
+/// Lightweight view of a contiguous range of elements, used to iterate adjacency lists without copying them
+template<class T>
+class ArrayRange {
+public:
+    ArrayRange(T const* begin, T const* end) : _begin(begin), _end(end) {}
+
+    [[nodiscard]] T const* begin() const { return _begin; }
+
+    [[nodiscard]] T const* end() const { return _end; }
+
+    [[nodiscard]] size_t size() const { return _end - _begin; }
+
+    [[nodiscard]] bool empty() const { return _begin == _end; }
+
+private:
+    T const* _begin;
+    T const* _end;
+};
+
+/// Determines how edges can be looked up by their endpoints
+enum class GraphStorage {
+    /// Adjacency lists only, memory O(n + m). Looking up an edge by its endpoints takes O(log(degree)).
+    sparse,
+    /// Additionally stores an adjacency matrix, memory O(n²). Only sensible for (nearly) complete graphs.
+    dense,
+    /**
+     * Instead of adjacency lists, stores an adjacency matrix with 16 bit weights if all weights fit (32 bit otherwise)
+     * and missing edges encoded as a sentinel weight: 2 n² bytes for 16 bit weights, where the adjacency lists take 24
+     * bytes per edge and dense storage 5 n² bytes on top of them. Together with the edge list (12 bytes per edge), a
+     * complete graph needs about 8 n² bytes instead of 18 n² (sparse) or 23 n² (dense). Looking up an edge by its
+     * endpoints takes constant time, its index O(log(degree)). Iterating the incidences of a node takes O(n).
+     */
+    compact_dense,
+};
+
+class IncidenceRange;
+
 /**
    @class Graph
 
    This class models unweighted undirected graphs only.
-   Edges (and edge costs) are stored as an adjacency matrix, if multiple parallel edges are added only the cheapest one
-   is considered.
+   Edges are stored as a sorted edge list and as adjacency lists in compressed sparse row (CSR) format, i.e. the
+   neighbors of node v are stored at positions [_offsets[v], _offsets[v + 1]) of _incidences. Optionally an adjacency
+   matrix is kept in addition for constant time lookups by endpoints, or instead of the adjacency lists with
+   GraphStorage::compact_dense.
 **/
 class Graph {
 public:
     /**
-       @brief Creates a @c Graph with @c num_nodes isolated nodes.
+       @brief Creates a @c Graph with @c num_nodes nodes and the given edges. @c weights[i] is the weight of @c edges[i].
 
-       The number of nodes in the graph currently cannot be changed. You can only add edges between the existing nodes.
+       The structure of the graph cannot be changed after construction, only its weights (see set_edge_weights).
+       Throws an exception if the edges contain loops or parallel edges. If @c lengths is not empty, @c lengths[i] is
+       the length of @c edges[i], otherwise every edge has length 1. Lengths are only supported by sparse storage.
     **/
-    explicit Graph(NodeId num_nodes);
+    Graph(NodeId num_nodes, std::vector<Edge> edges, std::vector<EdgeWeight> const& weights,
+          GraphStorage storage = GraphStorage::sparse, std::vector<EdgeLength> const& lengths = {});
 
     /** @return The number of nodes in the graph. **/
     [[nodiscard]] NodeId num_nodes() const;
 
-    /**
-       @brief Adds the edge <tt> {node1_id, node2_id} </tt> with specified weight.
+    /** @return The number of edges in the graph. **/
+    [[nodiscard]] EdgeIndex num_edges() const;
 
-       Checks that @c node1_id and @c node2_id are distinct and throws an exception otherwise.
-       @warning Does not check that the edge does not already exist, so this class can be used to model non-simple graphs.
-    **/
-    void add_edge(Edge to_add, EdgeWeight weight);
+    [[nodiscard]] GraphStorage storage() const;
+
+    /// The edges are sorted lexicographically, the lower node ID is always the first entry
+    [[nodiscard]] Edge const& edge(EdgeIndex index) const;
+
+    [[nodiscard]] EdgeWeight edge_weight(EdgeIndex index) const;
+
+    /// Does any edge have a length other than 1? The mean of a cycle is its weight divided by its length.
+    [[nodiscard]] bool has_edge_lengths() const;
+
+    [[nodiscard]] EdgeLength edge_length(EdgeIndex index) const;
+
+    /// The lengths of all edges indexed like the edges, empty if all edges have length 1
+    [[nodiscard]] std::vector<EdgeLength> const& edge_lengths() const;
+
+    /// The index of an existing edge, whose ends may be given in either order
+    [[nodiscard]] EdgeIndex edge_index(Edge const& edge) const;
+
+    /// The incidences are sorted by the ID of the neighbor. Not available with GraphStorage::compact_dense.
+    [[nodiscard]] ArrayRange<Incidence> neighbors(NodeId node) const;
+
+    /// Like neighbors, but with every storage. The incidences are created on the fly, see IncidenceIterator.
+    [[nodiscard]] IncidenceRange incidences(NodeId node) const;
+
+    /// The number of neighbors of node, in time O(n) with GraphStorage::compact_dense
+    [[nodiscard]] NodeId degree(NodeId node) const;
 
     [[nodiscard]] EdgeWeight edge_cost(Edge const& edge_id) const;
 
     [[nodiscard]] bool edge_exists(Edge const& edge) const;
 
+    /// Only with GraphStorage::dense: the weights of the edges from node to all nodes, 0 for missing edges
+    [[nodiscard]] EdgeWeight const* matrix_row(NodeId node) const;
+
+    /// Only with GraphStorage::dense: entry v is 1 if the edge from node to v exists, 0 otherwise
+    [[nodiscard]] char const* matrix_row_exists(NodeId node) const;
+
+    /// Only with GraphStorage::compact_dense: are the matrix weights stored as int16_t (otherwise as int32_t)?
+    [[nodiscard]] bool narrow_matrix() const;
+
+    /**
+     * Only with GraphStorage::compact_dense: the weights of the edges from node to all nodes. Missing edges (and the
+     * entry of node itself) have weight std::numeric_limits<T>::min(). T has to be int16_t if narrow_matrix() and
+     * int32_t otherwise.
+     */
+    template<class T>
+    [[nodiscard]] T const* compact_matrix_row(NodeId node) const;
+
+    /// The weights of all edges, indexed like the edges
+    [[nodiscard]] std::vector<EdgeWeight> const& edge_weights() const;
+
+    /**
+     * Replaces all edge weights, weights[i] becomes the weight of edge(i). Does not allocate memory, unless the compact
+     * matrix has 16 bit weights and a new weight does not fit.
+     */
+    void set_edge_weights(std::vector<EdgeWeight> const& weights);
+
+    /**
+     * Changes the weight of one edge in time O(log(degree)) (constant for the matrix storages). Like set_edge_weights,
+     * only allocates if the compact matrix has 16 bit weights and the new weight does not fit.
+     */
+    void set_edge_weight(EdgeIndex index, EdgeWeight weight);
+
     /**
      * @brief Reads a simple graph in DIMACS format from the given istream
      */
-    static Graph read_dimacs(std::istream& str);
+    static Graph read_dimacs(std::istream& str, GraphStorage storage = GraphStorage::sparse);
+
+    /**
+     * @brief Reads a simple graph in DIMACS format from the given file
+     *
+     * Equivalent to read_dimacs, but much faster on large files: the file is mapped into memory and parsed in place.
+     * The edge lines are split into chunks at line boundaries that are parsed by up to num_threads threads (0 means
+     * one per hardware thread).
+     */
+    static Graph read_dimacs_file(
+            std::string const& path, GraphStorage storage = GraphStorage::sparse, unsigned num_threads = 1
+    );
+
+    /// Writes the graph in DIMACS format, as read by read_dimacs
+    void write_dimacs(std::ostream& output) const;
+
+    /**
+     * @brief Writes the graph in the binary format read by read_binary_file
+     *
+     * The format stores the internal arrays of the graph together with a version and a checksum. It is meant as a
+     * cache for repeated runs on the same machine, DIMACS remains the interchange format. With
+     * GraphStorage::compact_dense, the adjacency lists of the format are built temporarily.
+     */
+    void write_binary_file(std::string const& path) const;
+
+    /**
+     * @brief Reads a graph written by write_binary_file
+     *
+     * Throws if the file has a different version, was written on a machine with different byte order, or (if
+     * verify_checksum is set) its contents do not match the stored checksum.
+     */
+    static Graph read_binary_file(
+            std::string const& path, GraphStorage storage = GraphStorage::sparse, bool verify_checksum = true
+    );
+
+    /// Reads a graph in binary format or in DIMACS format, depending on the contents of the file
+    static Graph read_file(
+            std::string const& path, GraphStorage storage = GraphStorage::sparse, unsigned num_threads = 1
+    );
 
 private:
+    /// Creates a graph without edges or adjacency lists, used by the readers that fill the members directly
+    Graph(NodeId num_nodes, GraphStorage storage);
+
+    static Graph parse_dimacs(char const* begin, char const* end, GraphStorage storage, unsigned num_threads);
+
+    static Graph parse_binary(char const* data, size_t size, GraphStorage storage, bool verify_checksum);
+
+    /**
+     * Fills _edge_costs and _edge_in_graph, or one of the compact matrices and _first_edge for
+     * GraphStorage::compact_dense. The latter releases the adjacency lists.
+     */
+    void build_adjacency_matrix();
+
+    /// Returns the incidence of the edge in the adjacency list of edge.first, or nullptr if the edge does not exist
+    [[nodiscard]] Incidence const* find_incidence(Edge const& edge) const;
+
+    /// Only with GraphStorage::compact_dense: the index of an existing edge, searched among the edges of its lower end
+    [[nodiscard]] EdgeIndex find_edge_index(Edge const& edge) const;
+
     /// Converts an edge (encoded as its endpoints) to an ID in _edge_costs and _edge_in_graph
-    [[nodiscard]] size_t edge_id(Edge const& edge) const;
+    [[nodiscard]] size_t matrix_index(Edge const& edge) const;
+
+    size_type const _num_nodes;
+    GraphStorage const _storage;
+    std::vector<Edge> _edges;
+    std::vector<EdgeWeight> _edge_weights;
+    /// Empty if every edge has length 1
+    std::vector<EdgeLength> _edge_lengths;
+    /// Size num_nodes + 1, empty with GraphStorage::compact_dense
+    std::vector<size_t> _offsets;
+    /// Size 2 * num_edges, every edge is stored once for each of its ends. Empty with GraphStorage::compact_dense.
+    std::vector<Incidence> _incidences;
 
-    /// Stores edge weights. The size of this vector is num_nodes². Half the size would be enough to store the data,
-    /// but storing the data for both "directions" of an edge allows for faster access.
+    /// Only used with GraphStorage::dense. Stores edge weights. The size of this vector is num_nodes². Half the size
+    /// would be enough to store the data, but storing the data for both "directions" of an edge allows for faster
+    /// access.
     std::vector<EdgeWeight> _edge_costs;
-    /// Stores 1 if an edge exists, 0 if it does not
+    /// Only used with GraphStorage::dense. Stores 1 if an edge exists, 0 if it does not
     std::vector<char> _edge_in_graph;
-    size_type const _num_nodes;
+    /// Only used with GraphStorage::compact_dense, and only one of them: the adjacency matrix, indexed like
+    /// _edge_costs. Missing edges have the minimum value of the type as weight.
+    std::vector<int16_t> _compact_matrix16;
+    std::vector<int32_t> _compact_matrix32;
+    /// Only used with GraphStorage::compact_dense: the edges with lower end v are _edges[_first_edge[v]], ...,
+    /// _edges[_first_edge[v + 1] - 1]. Size num_nodes + 1.
+    std::vector<EdgeIndex> _first_edge;
+
+    friend class IncidenceIterator;
 }; // class Graph
 
+/**
+ * Iterates the incidences of a node in order of the neighbor ID, with every storage. With GraphStorage::compact_dense,
+ * which has no adjacency lists, the neighbors are read from the matrix row: iterating all incidences of a node takes
+ * O(n) time, and dereferencing looks up the index of the edge in O(log(degree)).
+ */
+class IncidenceIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Incidence;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Incidence const*;
+    using reference = Incidence;
+
+    /// position is an index into the adjacency lists, or the neighbor with GraphStorage::compact_dense
+    IncidenceIterator(Graph const& graph, NodeId node, size_t position);
+
+    Incidence operator*() const;
+
+    IncidenceIterator& operator++();
+
+    IncidenceIterator operator++(int);
+
+    bool operator==(IncidenceIterator const& other) const;
+
+    bool operator!=(IncidenceIterator const& other) const;
+
+private:
+    /// Only with GraphStorage::compact_dense: moves _position forward to the next neighbor of _node (or to num_nodes)
+    void skip_non_neighbors();
+
+    Graph const* _graph;
+    NodeId _node;
+    size_t _position;
+};
+
+class IncidenceRange {
+public:
+    IncidenceRange(IncidenceIterator begin, IncidenceIterator end) : _begin(begin), _end(end) {}
+
+    [[nodiscard]] IncidenceIterator begin() const { return _begin; }
+
+    [[nodiscard]] IncidenceIterator end() const { return _end; }
+
+private:
+    IncidenceIterator _begin;
+    IncidenceIterator _end;
+};
+
 inline NodeId Graph::num_nodes() const {
     return _num_nodes;
 }
 
+inline EdgeIndex Graph::num_edges() const {
+    return static_cast<EdgeIndex>(_edges.size());
+}
+
+inline GraphStorage Graph::storage() const {
+    return _storage;
+}
+
+inline Edge const& Graph::edge(EdgeIndex const index) const {
+    return _edges[index];
+}
+
+inline EdgeWeight Graph::edge_weight(EdgeIndex const index) const {
+    return _edge_weights[index];
+}
+
+inline bool Graph::has_edge_lengths() const {
+    return not _edge_lengths.empty();
+}
+
+inline EdgeLength Graph::edge_length(EdgeIndex const index) const {
+    return _edge_lengths.empty() ? 1 : _edge_lengths[index];
+}
+
+inline std::vector<EdgeLength> const& Graph::edge_lengths() const {
+    return _edge_lengths;
+}
+
+inline EdgeIndex Graph::edge_index(Edge const& edge) const {
+    if (_storage == GraphStorage::compact_dense) {
+        return find_edge_index(edge);
+    }
+    auto const incidence = find_incidence(edge);
+    assert(incidence != nullptr);
+    return incidence->edge;
+}
+
+inline ArrayRange<Incidence> Graph::neighbors(NodeId const node) const {
+    assert(_storage != GraphStorage::compact_dense);
+    return {_incidences.data() + _offsets[node], _incidences.data() + _offsets[node + 1]};
+}
+
 inline bool Graph::edge_exists(Edge const& edge) const {
-    return _edge_in_graph[edge_id(edge)];
+    switch (_storage) {
+        case GraphStorage::dense:
+            return _edge_in_graph[matrix_index(edge)];
+        case GraphStorage::compact_dense:
+            return narrow_matrix()
+                   ? _compact_matrix16[matrix_index(edge)] != std::numeric_limits<int16_t>::min()
+                   : _compact_matrix32[matrix_index(edge)] != std::numeric_limits<int32_t>::min();
+        default:
+            return find_incidence(edge) != nullptr;
+    }
 }
 
 inline EdgeWeight Graph::edge_cost(Edge const& edge) const {
     assert(edge_exists(edge));
-    return _edge_costs[edge_id(edge)];
+    switch (_storage) {
+        case GraphStorage::dense:
+            return _edge_costs[matrix_index(edge)];
+        case GraphStorage::compact_dense:
+            return narrow_matrix() ? _compact_matrix16[matrix_index(edge)] : _compact_matrix32[matrix_index(edge)];
+        default:
+            return find_incidence(edge)->weight;
+    }
+}
+
+inline EdgeWeight const* Graph::matrix_row(NodeId const node) const {
+    assert(_storage == GraphStorage::dense);
+    return _edge_costs.data() + static_cast<size_t>(_num_nodes) * node;
+}
+
+inline char const* Graph::matrix_row_exists(NodeId const node) const {
+    assert(_storage == GraphStorage::dense);
+    return _edge_in_graph.data() + static_cast<size_t>(_num_nodes) * node;
+}
+
+inline bool Graph::narrow_matrix() const {
+    assert(_storage == GraphStorage::compact_dense);
+    return not _compact_matrix16.empty() or _compact_matrix32.empty();
+}
+
+template<>
+inline int16_t const* Graph::compact_matrix_row<int16_t>(NodeId const node) const {
+    assert(narrow_matrix());
+    return _compact_matrix16.data() + static_cast<size_t>(_num_nodes) * node;
+}
+
+template<>
+inline int32_t const* Graph::compact_matrix_row<int32_t>(NodeId const node) const {
+    assert(not narrow_matrix());
+    return _compact_matrix32.data() + static_cast<size_t>(_num_nodes) * node;
+}
+
+inline std::vector<EdgeWeight> const& Graph::edge_weights() const {
+    return _edge_weights;
+}
+
+inline size_t Graph::matrix_index(Edge const& edge) const {
+    return static_cast<size_t>(_num_nodes) * edge.first + edge.second;
+}
+
+inline IncidenceRange Graph::incidences(NodeId const node) const {
+    if (_storage == GraphStorage::compact_dense) {
+        return {IncidenceIterator(*this, node, 0), IncidenceIterator(*this, node, _num_nodes)};
+    }
+    return {IncidenceIterator(*this, node, _offsets[node]), IncidenceIterator(*this, node, _offsets[node + 1])};
+}
+
+inline NodeId Graph::degree(NodeId const node) const {
+    if (_storage == GraphStorage::compact_dense) {
+        return static_cast<NodeId>(std::distance(incidences(node).begin(), incidences(node).end()));
+    }
+    return static_cast<NodeId>(_offsets[node + 1] - _offsets[node]);
+}
+
+inline IncidenceIterator::IncidenceIterator(Graph const& graph, NodeId const node, size_t const position)
+        : _graph(&graph), _node(node), _position(position) {
+    skip_non_neighbors();
+}
+
+inline Incidence IncidenceIterator::operator*() const {
+    if (_graph->_storage != GraphStorage::compact_dense) {
+        return _graph->_incidences[_position];
+    }
+    auto const neighbor = static_cast<NodeId>(_position);
+    Edge const edge{std::min(_node, neighbor), std::max(_node, neighbor)};
+    return Incidence{neighbor, _graph->edge_cost(edge), _graph->find_edge_index(edge)};
+}
+
+inline IncidenceIterator& IncidenceIterator::operator++() {
+    ++_position;
+    skip_non_neighbors();
+    return *this;
+}
+
+inline IncidenceIterator IncidenceIterator::operator++(int) {
+    auto const previous = *this;
+    ++*this;
+    return previous;
+}
+
+inline bool IncidenceIterator::operator==(IncidenceIterator const& other) const {
+    return _position == other._position;
+}
+
+inline bool IncidenceIterator::operator!=(IncidenceIterator const& other) const {
+    return _position != other._position;
 }
 
-inline size_t Graph::edge_id(Edge const& edge) const {
-    return _num_nodes * edge.first + edge.second;
+inline void IncidenceIterator::skip_non_neighbors() {
+    if (_graph->_storage != GraphStorage::compact_dense) {
+        return;
+    }
+    // The entry of _node itself holds the sentinel as well
+    auto const num_nodes = _graph->_num_nodes;
+    if (_graph->narrow_matrix()) {
+        auto const row = _graph->compact_matrix_row<int16_t>(_node);
+        while (_position < num_nodes and row[_position] == std::numeric_limits<int16_t>::min()) {
+            ++_position;
+        }
+    } else {
+        auto const row = _graph->compact_matrix_row<int32_t>(_node);
+        while (_position < num_nodes and row[_position] == std::numeric_limits<int32_t>::min()) {
+            ++_position;
+        }
+    }
 }
 
 } // namespace MMC
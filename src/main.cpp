@@ -1,47 +1,358 @@
+#include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include "graph.h"
-#include "MinimumMeanCycleCalculator.h"
+#include "BatchSolver.h"
+#include "Digraph.h"
+#include "DirectedMinimumMeanCycleCalculator.h"
+#include "Solver.h"
 
-int main(int argc, char** argv) {
-    using namespace MMC;
-    if (argc != 3) {
+namespace {
+
+struct Arguments {
+    std::string input_path;
+    std::string output_path;
+    MMC::GraphStorage storage = MMC::GraphStorage::sparse;
+    /// If not empty, the input graph is also written in binary format to this path
+    std::string binary_output_path;
+    /// If not empty, statistics on the iterations are written as JSON to this path
+    std::string profile_path;
+    MMC::MinimumMeanCycleOptions options{};
+    /// In batch mode, input_path is a manifest or a directory and output_path the output directory
+    bool batch = false;
+    /// The input is a digraph in DIMACS arc format, solved with directed_algorithm instead of T-joins
+    bool directed = false;
+    MMC::DirectedAlgorithm directed_algorithm = MMC::DirectedAlgorithm::howard;
+    unsigned num_jobs = 0;
+    size_t memory_limit_bytes = 0;
+};
+
+void print_usage(char const* program_name) {
+    std::cout << "Usage: " << program_name << " [options] <input graph> <output graph>\n"
+              << "       " << program_name << " [options] --batch <manifest or directory> <output directory>\n"
+              << "The input graph can be given in DIMACS format or in the binary format written by --write-binary.\n"
+              << "In batch mode, all graphs of a directory or listed in a manifest (one input path per line,\n"
+              << "optionally followed by a tab and an output path) are solved, and a summary is written to\n"
+              << "summary.tsv in the output directory.\n"
+              << "With --directed, the input is a digraph in DIMACS arc format (\"p sp <nodes> <arcs>\" followed by\n"
+              << "lines \"a <tail> <head> <weight>\") and the cycle is written in the same format.\n"
+              << "Options:\n"
+              << "  --dense                      Additionally store the graph as an adjacency matrix (faster for complete\n"
+              << "                               graphs)\n"
+              << "  --compact-dense              Store an adjacency matrix of 16 or 32 bit weights instead of\n"
+              << "                               adjacency lists: a complete graph on n nodes takes about 8 n²\n"
+              << "                               bytes (10 n² with 32 bit weights) instead of 18 n² (default) or\n"
+              << "                               23 n² (--dense)\n"
+              << "  --t-join <all-pairs|voronoi> Algorithm for minimum T-joins: matching on all pairs of odd nodes\n"
+              << "                               (default) or on a sparse Voronoi-based instance with pricing\n"
+              << "  --threads <N>                Number of threads for parsing the input and the shortest path\n"
+              << "                               computations, 0 uses all hardware threads (default 1)\n"
+              << "  --no-warm-start              Solve every matching from scratch instead of reusing the previous one\n"
+              << "  --prune-pairs                In the all-pairs T-join, skip pairs of odd nodes that provably cannot\n"
+              << "                               be in a minimum matching, using nearest neighbour bounds\n"
+              << "  --no-decompose               Solve the whole graph at once instead of every biconnected component\n"
+              << "                               with a cycle separately\n"
+              << "  --no-reduce                  Do not remove leaves and contract paths through nodes of degree 2\n"
+              << "                               before solving\n"
+              << "  --search <newton|stern-brocot|hybrid>\n"
+              << "                               How the next gamma is chosen (default newton)\n"
+              << "  --epsilon <E>                Stop once the mean of the best cycle found is within a relative\n"
+              << "                               tolerance E of the proven lower bound, and write both bounds as\n"
+              << "                               comment lines to the output (default 0, i.e. exact)\n"
+              << "  --directed                   Find a minimum mean directed cycle of a digraph with Howard's policy\n"
+              << "                               iteration, see above. --threads also sets the number of strongly\n"
+              << "                               connected components solved concurrently.\n"
+              << "  --karp                       With --directed, use Karp's algorithm instead of Howard's: O(n m)\n"
+              << "                               time and O(n²) memory, meant as a reference for small instances\n"
+              << "  --write-binary <path>        Also write the input graph in binary format, for faster loading in\n"
+              << "                               later runs\n"
+              << "  --profile-json <path>        Write timings of all T-join computations as JSON. Phase timings and\n"
+              << "                               counters are only available if built with MMC_INSTRUMENTATION\n"
+              << "  --batch                      Batch mode, see above\n"
+              << "  --jobs <N>                   Number of graphs solved concurrently in batch mode, 0 uses all\n"
+              << "                               hardware threads (default 0)\n"
+              << "  --memory-limit <MB>          Limit on the estimated memory of the graphs solved concurrently in\n"
+              << "                               batch mode (default no limit)\n";
+}
+
+/**
+ * Parses a non-negative decimal integer of at most max_value. Unlike std::stoul, it rejects a sign (stoul wraps "-1"
+ * around to the largest value), trailing characters and values that do not fit.
+ */
+std::optional<unsigned long long> parse_unsigned(std::string const& text, unsigned long long const max_value) {
+    if (text.empty() or text[0] < '0' or text[0] > '9') {
+        return std::nullopt;
+    }
+    size_t num_parsed = 0;
+    unsigned long long value;
+    try {
+        value = std::stoull(text, &num_parsed);
+    } catch (std::exception const&) {
+        return std::nullopt;
+    }
+    if (num_parsed != text.size() or value > max_value) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<Arguments> parse_arguments(int argc, char** argv) {
+    Arguments result;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string const argument{argv[i]};
+        if (argument == "--dense") {
+            result.storage = MMC::GraphStorage::dense;
+        } else if (argument == "--compact-dense") {
+            result.storage = MMC::GraphStorage::compact_dense;
+        } else if (argument == "--t-join" and i + 1 < argc) {
+            std::string const strategy{argv[++i]};
+            if (strategy == "all-pairs") {
+                result.options.t_join.strategy = MMC::TJoinStrategy::all_pairs;
+            } else if (strategy == "voronoi") {
+                result.options.t_join.strategy = MMC::TJoinStrategy::voronoi_pricing;
+            } else {
+                std::cout << "Unknown T-join strategy " << strategy << std::endl;
+                return std::nullopt;
+            }
+        } else if (argument == "--threads" and i + 1 < argc) {
+            auto const num_threads = parse_unsigned(argv[++i], std::numeric_limits<unsigned>::max());
+            if (not num_threads) {
+                std::cout << "Invalid number of threads " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+            result.options.t_join.num_threads = static_cast<unsigned>(*num_threads);
+        } else if (argument == "--search" and i + 1 < argc) {
+            std::string const strategy{argv[++i]};
+            if (strategy == "newton") {
+                result.options.search_strategy = MMC::GammaSearchStrategy::newton;
+            } else if (strategy == "stern-brocot") {
+                result.options.search_strategy = MMC::GammaSearchStrategy::stern_brocot;
+            } else if (strategy == "hybrid") {
+                result.options.search_strategy = MMC::GammaSearchStrategy::hybrid;
+            } else {
+                std::cout << "Unknown search strategy " << strategy << std::endl;
+                return std::nullopt;
+            }
+        } else if (argument == "--epsilon" and i + 1 < argc) {
+            try {
+                result.options.epsilon = std::stod(argv[++i]);
+            } catch (std::exception const&) {
+                result.options.epsilon = -1;
+            }
+            if (not(result.options.epsilon >= 0)) {
+                std::cout << "Invalid tolerance " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+        } else if (argument == "--write-binary" and i + 1 < argc) {
+            result.binary_output_path = argv[++i];
+        } else if (argument == "--profile-json" and i + 1 < argc) {
+            result.profile_path = argv[++i];
+        } else if (argument == "--no-warm-start") {
+            result.options.t_join.warm_start = false;
+        } else if (argument == "--no-decompose") {
+            result.options.decompose = false;
+        } else if (argument == "--no-reduce") {
+            result.options.reduce = false;
+        } else if (argument == "--prune-pairs") {
+            result.options.t_join.prune_pairs = true;
+        } else if (argument == "--batch") {
+            result.batch = true;
+        } else if (argument == "--directed") {
+            result.directed = true;
+        } else if (argument == "--karp") {
+            result.directed_algorithm = MMC::DirectedAlgorithm::karp;
+        } else if ((argument == "--jobs" or argument == "--memory-limit") and i + 1 < argc) {
+            // The memory limit is given in MiB and has to fit into size_t once converted to bytes
+            auto const max_value = argument == "--jobs" ? std::numeric_limits<unsigned>::max()
+                                                        : std::numeric_limits<size_t>::max() >> 20;
+            auto const value = parse_unsigned(argv[++i], max_value);
+            if (not value) {
+                std::cout << "Invalid value " << argv[i] << " for " << argument << std::endl;
+                return std::nullopt;
+            }
+            if (argument == "--jobs") {
+                result.num_jobs = static_cast<unsigned>(*value);
+            } else {
+                result.memory_limit_bytes = static_cast<size_t>(*value) << 20;
+            }
+        } else if (argument.rfind("--", 0) == 0) {
+            std::cout << "Unknown option " << argument << std::endl;
+            return std::nullopt;
+        } else {
+            positional.push_back(argument);
+        }
+    }
+    if (positional.size() != 2) {
         std::cout << "Expected exactly two arguments (path to input graph and path to output graph)!" << std::endl;
+        return std::nullopt;
+    }
+    if (result.batch and not(result.binary_output_path.empty() and result.profile_path.empty())) {
+        std::cout << "--write-binary and --profile-json are not supported in batch mode" << std::endl;
+        return std::nullopt;
+    }
+    if (result.directed and (result.batch or result.storage != MMC::GraphStorage::sparse or
+                             not(result.binary_output_path.empty() and result.profile_path.empty()))) {
+        std::cout << "--batch, --dense, --compact-dense, --write-binary and --profile-json are not supported with "
+                  << "--directed" << std::endl;
+        return std::nullopt;
+    }
+    if (result.directed_algorithm == MMC::DirectedAlgorithm::karp and not result.directed) {
+        std::cout << "--karp requires --directed" << std::endl;
+        return std::nullopt;
+    }
+    result.input_path = positional[0];
+    result.output_path = positional[1];
+    return result;
+}
+
+void write_profile(std::string const& path, MMC::Solver const& solver) {
+    std::ofstream output(path, std::ios::out | std::ios::trunc);
+    if (not output) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+    output << "{\n  \"instrumentation\": " << (MMC::instrumentation_enabled ? "true" : "false") << ",\n"
+           << "  \"total\": ";
+    solver.profile().write_json(output);
+    output << ",\n  \"iterations\": [";
+    for (size_t i = 0; i < solver.iterations().size(); ++i) {
+        auto const& iteration = solver.iterations()[i];
+        output << (i == 0 ? "\n" : ",\n")
+               << "    {\"gamma\": " << static_cast<double>(iteration.gamma) << ", "
+               << "\"gamma_cost_sum\": " << iteration.gamma.cost_sum << ", "
+               << "\"gamma_num_edges\": " << iteration.gamma.num_edges << ", "
+               << "\"seconds\": " << iteration.seconds << ", "
+               << "\"found_cheaper_cycle\": " << (iteration.found_cheaper_cycle ? "true" : "false") << ", "
+               << "\"profile\": ";
+        iteration.profile.write_json(output);
+        output << '}';
+    }
+    output << "\n  ]\n}\n";
+}
+
+int run_batch(Arguments const& arguments) {
+    using namespace MMC;
+    try {
+        std::filesystem::create_directories(arguments.output_path);
+        auto const jobs = std::filesystem::is_directory(arguments.input_path) ?
+                          list_batch_directory(arguments.input_path, arguments.output_path) :
+                          read_batch_manifest(arguments.input_path, arguments.output_path);
+        BatchOptions options;
+        options.solver = arguments.options;
+        options.storage = arguments.storage;
+        options.num_jobs = arguments.num_jobs;
+        options.memory_limit_bytes = arguments.memory_limit_bytes;
+        auto const results = solve_batch(jobs, options);
+
+        auto const summary_path = (std::filesystem::path(arguments.output_path) / "summary.tsv").string();
+        std::ofstream summary(summary_path, std::ios::out | std::ios::trunc);
+        if (not summary) {
+            throw std::runtime_error("Failed to open " + summary_path);
+        }
+        write_batch_summary(summary, results);
+        size_t num_failed = 0;
+        for (auto const& result : results) {
+            if (not result.success) {
+                ++num_failed;
+                std::cerr << result.job.input_path << ": " << result.error << '\n';
+            }
+        }
+        std::cout << "Solved " << results.size() - num_failed << " of " << results.size() << " instances, summary "
+                  << "written to " << summary_path << '\n';
+        return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (std::exception const& xcp) {
+        std::cerr << "Caught exception: " << xcp.what() << '\n';
         return EXIT_FAILURE;
     }
-    std::fstream input_file{argv[1]};
-    if (input_file.fail()) {
-        std::cout << "Failed to open the input file. Exiting." << std::endl;
+}
+
+int run_directed(Arguments const& arguments, std::ostream& output) {
+    using namespace MMC;
+    try {
+        auto const graph = Digraph::read_dimacs_file(arguments.input_path, arguments.options.t_join.num_threads);
+        DirectedMinimumMeanCycleOptions options;
+        options.algorithm = arguments.directed_algorithm;
+        options.num_threads = arguments.options.t_join.num_threads;
+        DirectedMinimumMeanCycleCalculator calculator(graph, options);
+        auto const mmc_gamma_opt = calculator.find_mmc();
+        std::cout << "Strongly connected components with a cycle: " << calculator.num_components();
+        if (arguments.directed_algorithm == DirectedAlgorithm::howard) {
+            std::cout << ", policy iterations: " << calculator.num_iterations();
+        }
+        std::cout << '\n';
+        if (mmc_gamma_opt) {
+            std::cout << "Mean of the cycle: " << static_cast<double>(mmc_gamma_opt->second) << '\n';
+        }
+        write_cycle(output, graph, mmc_gamma_opt);
+        output << std::flush;
+        return EXIT_SUCCESS;
+    } catch (std::exception const& xcp) {
+        std::cerr << "Caught exception: " << xcp.what() << '\n';
         return EXIT_FAILURE;
     }
-    std::ofstream output_file(argv[2], std::ios::out | std::ios::trunc);
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char** argv) {
+    using namespace MMC;
+    auto const arguments = parse_arguments(argc, argv);
+    if (not arguments) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (arguments->batch) {
+        return run_batch(*arguments);
+    }
+    std::ofstream output_file(arguments->output_path, std::ios::out | std::ios::trunc);
     if (output_file.fail()) {
         std::cout << "Failed to open the output file. Exiting." << std::endl;
         return EXIT_FAILURE;
     }
+    if (arguments->directed) {
+        return run_directed(*arguments, output_file);
+    }
     try {
-        auto const graph = Graph::read_dimacs(input_file);
-
-        MinimumMeanCycleCalculator calc(graph);
-        auto const mmc_gamma_opt = calc.find_mmc();
-        output_file << "p edge " << graph.num_nodes() << ' ';
+        Solver solver(arguments->options);
+        solver.read_graph(arguments->input_path, arguments->storage);
+        auto const& graph = solver.graph();
+        if (not arguments->binary_output_path.empty()) {
+            graph.write_binary_file(arguments->binary_output_path);
+        }
 
+        auto const mmc_gamma_opt = solver.solve();
+        auto const& matching_statistics = solver.matching_statistics();
+        std::cout << "Matching solves: " << matching_statistics.num_cold_solves << " cold ("
+                  << matching_statistics.cold_solve_seconds << "s), " << matching_statistics.num_warm_solves
+                  << " warm (" << matching_statistics.warm_solve_seconds << "s), estimated time saved by warm starts: "
+                  << matching_statistics.estimated_seconds_saved() << "s\n";
+        double total_iteration_seconds = 0;
+        for (auto const& iteration : solver.iterations()) {
+            total_iteration_seconds += iteration.seconds;
+        }
+        std::cout << "T-join computations: " << solver.iterations().size() << " (" << total_iteration_seconds
+                  << "s)\n";
+        for (size_t i = 0; i < solver.iterations().size(); ++i) {
+            auto const& iteration = solver.iterations()[i];
+            std::cout << "  " << i << ": gamma=" << static_cast<double>(iteration.gamma) << ", "
+                      << iteration.seconds << "s, " << (iteration.found_cheaper_cycle ? "cheaper cycle found" :
+                                                        "lower bound") << '\n';
+        }
+        if (not arguments->profile_path.empty()) {
+            write_profile(arguments->profile_path, solver);
+        }
         if (mmc_gamma_opt) {
-            // Write edges of minimum mean cycle
-            auto const&[mmc, gamma] = *mmc_gamma_opt;
-            output_file << mmc.size() << '\n';
-            for (auto const& edge : mmc) {
-                output_file << "e ";
-                for (auto const end : {edge.first, edge.second}) {
-                    output_file << (end + 1) << ' ';
-                }
-                output_file << graph.edge_cost(edge) << '\n';
-            }
-        } else {
-            // Graph is acyclic
-            output_file << "0\n";
+            std::cout << "Mean of the cycle: " << static_cast<double>(mmc_gamma_opt->second) << ", lower bound: "
+                      << static_cast<double>(solver.lower_bound()) << '\n';
         }
+        auto const lower_bound = arguments->options.epsilon > 0 ? std::optional<Gamma>(solver.lower_bound())
+                                                                : std::nullopt;
+        write_cycle(output_file, graph, mmc_gamma_opt, lower_bound);
         output_file << std::flush;
 
         return EXIT_SUCCESS;
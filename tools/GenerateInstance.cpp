@@ -0,0 +1,151 @@
+/**
+ * Generates random test instances, a faster and more flexible replacement for generate_random_Kn.tcl.
+ *
+ * Usage: mmc_generate [options] <family> <parameters...>
+ * The graph is written in DIMACS format to stdout or, with --output, to a file in DIMACS or binary format.
+ */
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+#include "InstanceGenerator.h"
+
+namespace {
+
+struct Arguments {
+    std::string family;
+    std::vector<std::string> parameters;
+    uint64_t seed = 1;
+    MMC::EdgeWeight max_absolute_weight = 1000;
+    std::string output_path;
+    bool binary = false;
+};
+
+void print_usage(char const* program_name) {
+    std::cout << "Usage: " << program_name << " [options] <family> <parameters...>\n"
+              << "Families:\n"
+              << "  complete <n>                 Complete graph on n nodes\n"
+              << "  gnm <n> <m>                  Uniformly random graph with n nodes and m edges\n"
+              << "  grid <rows> <columns>        Grid graph\n"
+              << "  planar <rows> <columns>      Grid graph with a random diagonal in every cell\n"
+              << "  geometric <n> <degree>       Random geometric graph in the unit square with the given expected\n"
+              << "                               average degree\n"
+              << "  newton-adversarial <k>       Graph on which Newton's method needs k T-join computations, weights\n"
+              << "                               are fixed (1 <= k <= 12, about 4^k edges)\n"
+              << "Options:\n"
+              << "  --seed <N>                   Seed of the random generator (default 1)\n"
+              << "  --max-weight <W>             Weights are drawn uniformly from [-W, W] (default 1000)\n"
+              << "  --output <path>              Write to this file instead of stdout\n"
+              << "  --binary                     Write the binary format read by MinimumMeanCycle (needs --output)\n";
+}
+
+std::optional<Arguments> parse_arguments(int argc, char** argv) {
+    Arguments result;
+    std::vector<std::string> positional;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string const argument{argv[i]};
+            if (argument == "--seed" and i + 1 < argc) {
+                result.seed = std::stoull(argv[++i]);
+            } else if (argument == "--max-weight" and i + 1 < argc) {
+                result.max_absolute_weight = static_cast<MMC::EdgeWeight>(std::stol(argv[++i]));
+            } else if (argument == "--output" and i + 1 < argc) {
+                result.output_path = argv[++i];
+            } else if (argument == "--binary") {
+                result.binary = true;
+            } else if (argument.rfind("--", 0) == 0) {
+                std::cout << "Unknown option " << argument << std::endl;
+                return std::nullopt;
+            } else {
+                positional.push_back(argument);
+            }
+        }
+    } catch (std::exception const&) {
+        std::cout << "Invalid number" << std::endl;
+        return std::nullopt;
+    }
+    if (positional.empty()) {
+        std::cout << "Missing graph family" << std::endl;
+        return std::nullopt;
+    }
+    if (result.binary and result.output_path.empty()) {
+        std::cout << "--binary requires --output" << std::endl;
+        return std::nullopt;
+    }
+    result.family = positional.front();
+    result.parameters.assign(positional.begin() + 1, positional.end());
+    return result;
+}
+
+MMC::Graph generate(Arguments const& arguments) {
+    using MMC::NodeId;
+    auto const& parameters = arguments.parameters;
+    auto const expect_parameters = [&](size_t const count) {
+        if (parameters.size() != count) {
+            throw std::runtime_error(
+                    "Family " + arguments.family + " expects " + std::to_string(count) + " parameter(s)."
+            );
+        }
+    };
+    auto const node_count = [](std::string const& parameter) {
+        auto const value = std::stoull(parameter);
+        if (value > std::numeric_limits<NodeId>::max()) {
+            throw std::runtime_error("Too many nodes: " + parameter);
+        }
+        return static_cast<NodeId>(value);
+    };
+    MMC::InstanceGenerator generator(arguments.seed, arguments.max_absolute_weight);
+    if (arguments.family == "complete") {
+        expect_parameters(1);
+        return generator.complete(node_count(parameters[0]));
+    } else if (arguments.family == "gnm") {
+        expect_parameters(2);
+        return generator.random_sparse(node_count(parameters[0]), node_count(parameters[1]));
+    } else if (arguments.family == "grid") {
+        expect_parameters(2);
+        return generator.grid(node_count(parameters[0]), node_count(parameters[1]));
+    } else if (arguments.family == "planar") {
+        expect_parameters(2);
+        return generator.planar(node_count(parameters[0]), node_count(parameters[1]));
+    } else if (arguments.family == "geometric") {
+        expect_parameters(2);
+        return generator.geometric(node_count(parameters[0]), std::stod(parameters[1]));
+    } else if (arguments.family == "newton-adversarial") {
+        expect_parameters(1);
+        return MMC::InstanceGenerator::newton_adversarial(static_cast<unsigned>(std::stoul(parameters[0])));
+    }
+    throw std::runtime_error("Unknown graph family " + arguments.family);
+}
+
+}
+
+int main(int argc, char** argv) {
+    auto const arguments = parse_arguments(argc, argv);
+    if (not arguments) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    try {
+        auto const graph = generate(*arguments);
+        if (arguments->binary) {
+            graph.write_binary_file(arguments->output_path);
+        } else if (not arguments->output_path.empty()) {
+            std::ofstream output(arguments->output_path, std::ios::out | std::ios::trunc);
+            if (not output) {
+                throw std::runtime_error("Failed to open " + arguments->output_path);
+            }
+            graph.write_dimacs(output);
+        } else {
+            std::ios::sync_with_stdio(false);
+            graph.write_dimacs(std::cout);
+        }
+        return EXIT_SUCCESS;
+    } catch (std::exception const& xcp) {
+        std::cerr << "Caught exception: " << xcp.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}